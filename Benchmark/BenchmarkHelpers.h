@@ -0,0 +1,26 @@
+#ifndef BENCHMARK_HELPERS_H
+#define BENCHMARK_HELPERS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// steady clock in ns, comparable between threads
+inline int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// p in [0, 1], reorders samples. Returns 0 without samples.
+inline int64_t Percentile(std::vector<int64_t>& samples, double p)
+{
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+#endif
\ No newline at end of file
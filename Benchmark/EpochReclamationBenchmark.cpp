@@ -0,0 +1,67 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "EpochReclamation.h"
+
+namespace {
+
+struct Node {
+    int64_t value;
+    Node* next;
+};
+
+std::unique_ptr<EpochDomain> g_domain;
+
+} // namespace
+
+// Cost of pinning and unpinning the epoch, all threads in one domain.
+void BM_GuardEnterExit(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        g_domain = std::make_unique<EpochDomain>();
+    }
+    for (auto _ : state) {
+        EpochDomain::Guard guard(*g_domain);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        g_domain.reset();
+    }
+}
+BENCHMARK(BM_GuardEnterExit)->ThreadRange(1, 16);
+
+// Baseline for BM_Retire: the node is freed right away.
+void BM_NewDelete(benchmark::State& state)
+{
+    int64_t i = 0;
+    for (auto _ : state) {
+        Node* node = new Node{i++, nullptr};
+        benchmark::DoNotOptimize(node);
+        delete node;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NewDelete)->ThreadRange(1, 16);
+
+// Allocate a node and retire it under a Guard. range(0) is the batch size of the domain.
+void BM_Retire(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        g_domain = std::make_unique<EpochDomain>(state.range(0));
+    }
+    int64_t i = 0;
+    for (auto _ : state) {
+        EpochDomain::Guard guard(*g_domain);
+        Node* node = new Node{i++, nullptr};
+        benchmark::DoNotOptimize(node);
+        g_domain->Retire(node);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        // frees what is still pending
+        g_domain.reset();
+    }
+}
+BENCHMARK(BM_Retire)->ArgName("batch")->Arg(16)->Arg(64)->Arg(256)->ThreadRange(1, 16);
\ No newline at end of file
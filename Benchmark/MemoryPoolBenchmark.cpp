@@ -0,0 +1,141 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "MemoryPool.h"
+
+namespace {
+
+template <size_t Size>
+struct Object {
+    char data[Size];
+};
+
+const size_t LIVE_OBJECTS = 1024;
+
+template <typename T, bool ThreadSafe>
+struct PoolAllocation {
+    static constexpr const char* NAME = ThreadSafe ? "MemoryPool<ThreadSafe>" : "MemoryPool";
+    MemoryPool<T, std::max<size_t>(4096, sizeof(T) * 64), ThreadSafe> pool;
+    T* New() { return pool.NewElement(); }
+    void Delete(T* p) { pool.DeleteElement(p); }
+};
+
+template <typename T>
+struct NewDeleteAllocation {
+    static constexpr const char* NAME = "new/delete";
+    T* New() { return new T(); }
+    void Delete(T* p) { delete p; }
+};
+
+template <typename T>
+struct MallocAllocation {
+    static constexpr const char* NAME = "malloc/free";
+    T* New() { return new (std::malloc(sizeof(T))) T(); }
+    void Delete(T* p)
+    {
+        p->~T();
+        std::free(p);
+    }
+};
+
+// Allocate LIVE_OBJECTS objects, then free them in reverse order.
+template <typename Allocation>
+void BM_AllocLifo(benchmark::State& state)
+{
+    Allocation allocation;
+    std::vector<decltype(allocation.New())> objects(LIVE_OBJECTS);
+    for (auto _ : state) {
+        for (auto& p : objects) {
+            p = allocation.New();
+        }
+        benchmark::ClobberMemory();
+        for (auto it = objects.rbegin(); it != objects.rend(); ++it) {
+            allocation.Delete(*it);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * LIVE_OBJECTS);
+}
+
+// Allocate LIVE_OBJECTS objects, then free them in allocation order.
+template <typename Allocation>
+void BM_AllocFifo(benchmark::State& state)
+{
+    Allocation allocation;
+    std::vector<decltype(allocation.New())> objects(LIVE_OBJECTS);
+    for (auto _ : state) {
+        for (auto& p : objects) {
+            p = allocation.New();
+        }
+        benchmark::ClobberMemory();
+        for (auto& p : objects) {
+            allocation.Delete(p);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * LIVE_OBJECTS);
+}
+
+// Keep LIVE_OBJECTS objects alive and replace a random one per operation,
+// which fragments the free list. The seed is fixed for reproducible runs.
+template <typename Allocation>
+void BM_AllocRandom(benchmark::State& state)
+{
+    Allocation allocation;
+    std::vector<decltype(allocation.New())> objects(LIVE_OBJECTS);
+    for (auto& p : objects) {
+        p = allocation.New();
+    }
+    // precomputed so that random number generation is not measured
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> distrib(0, LIVE_OBJECTS - 1);
+    std::vector<size_t> indices(LIVE_OBJECTS * 64);
+    for (auto& index : indices) {
+        index = distrib(gen);
+    }
+
+    size_t next = 0;
+    for (auto _ : state) {
+        for (size_t i = 0; i < LIVE_OBJECTS; ++i) {
+            size_t index = indices[next++ % indices.size()];
+            allocation.Delete(objects[index]);
+            objects[index] = allocation.New();
+        }
+    }
+    for (auto& p : objects) {
+        allocation.Delete(p);
+    }
+    state.SetItemsProcessed(state.iterations() * LIVE_OBJECTS);
+}
+
+template <typename Allocation>
+void RegisterPatterns(size_t size)
+{
+    std::string suffix = std::string("/") + Allocation::NAME + "/" + std::to_string(size) + "B";
+    benchmark::RegisterBenchmark(("BM_AllocLifo" + suffix).c_str(), BM_AllocLifo<Allocation>);
+    benchmark::RegisterBenchmark(("BM_AllocFifo" + suffix).c_str(), BM_AllocFifo<Allocation>);
+    benchmark::RegisterBenchmark(("BM_AllocRandom" + suffix).c_str(), BM_AllocRandom<Allocation>);
+}
+
+template <size_t Size>
+void RegisterSize()
+{
+    using T = Object<Size>;
+    RegisterPatterns<PoolAllocation<T, false>>(Size);
+    RegisterPatterns<PoolAllocation<T, true>>(Size);
+    RegisterPatterns<NewDeleteAllocation<T>>(Size);
+    RegisterPatterns<MallocAllocation<T>>(Size);
+}
+
+const int g_registered = []() {
+    RegisterSize<64>();
+    RegisterSize<1500>();
+    return 0;
+}();
+
+} // namespace
\ No newline at end of file
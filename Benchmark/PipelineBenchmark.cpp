@@ -0,0 +1,81 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "BenchmarkHelpers.h"
+#include "Pipeline.h"
+
+namespace {
+
+const size_t PAYLOAD = 64;
+// one latency sample per SAMPLE_EVERY packets
+const uint64_t SAMPLE_EVERY = 64;
+
+// a little per-packet work, so that stages are not pure ring traffic
+bool Checksum(PktBuffer& packet)
+{
+    uint32_t sum = 0;
+    for (size_t i = 0; i < packet.length; ++i) {
+        sum += packet.data[i];
+    }
+    benchmark::DoNotOptimize(sum);
+    return true;
+}
+
+} // namespace
+
+// End-to-end packets/s and per-packet latency from Submit to the last stage.
+// range(0) is the number of stages, range(1) the batch size and range(2) the
+// tasks per stage. The benchmark thread is the only producer.
+void BM_Pipeline(benchmark::State& state)
+{
+    Pipeline::Options options;
+    options.batchSize = state.range(1);
+    Pipeline pipeline(options);
+    size_t parallelism = state.range(2);
+    for (int64_t i = 1; i < state.range(0); ++i) {
+        pipeline.AddStage(Checksum, parallelism);
+    }
+
+    std::mutex mutex;
+    std::vector<int64_t> latencies;
+    pipeline.AddStage([&mutex, &latencies](PktBuffer& packet) {
+        Checksum(packet);
+        uint64_t sequence;
+        std::memcpy(&sequence, packet.data, sizeof(sequence));
+        if (sequence % SAMPLE_EVERY == 0) {
+            int64_t latency = NowNs() - packet.timestamp;
+            std::lock_guard<std::mutex> lock(mutex);
+            latencies.push_back(latency);
+        }
+        return true;
+    }, parallelism);
+    pipeline.Start();
+
+    {
+        Pipeline::Producer producer(pipeline);
+        uint64_t sequence = 0;
+        for (auto _ : state) {
+            PktBuffer* packet = producer.Acquire();
+            std::memset(packet->data, 0, PAYLOAD);
+            std::memcpy(packet->data, &sequence, sizeof(sequence));
+            packet->length = PAYLOAD;
+            producer.Submit(packet);
+            ++sequence;
+        }
+        producer.Flush();
+    }
+    pipeline.Stop();
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["latency_p50_ns"] = static_cast<double>(Percentile(latencies, 0.50));
+    state.counters["latency_p99_ns"] = static_cast<double>(Percentile(latencies, 0.99));
+}
+BENCHMARK(BM_Pipeline)
+    ->ArgNames({"stages", "batch", "parallelism"})
+    ->ArgsProduct({{1, 2, 4}, {1, 8, 32}, {1, 2}})
+    ->UseRealTime();
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "BenchmarkHelpers.h"
+#include "LockRingBuffer.h"
+
+namespace {
+
+struct Item {
+    int64_t sendTime;
+};
+
+const int64_t MAX_LATENCY_SAMPLES = 1 << 16;
+
+std::unique_ptr<RingBuffer<Item>> g_buffer;
+// one slot per thread, filled by consumers in their last iteration
+std::vector<std::vector<int64_t>> g_latencies;
+
+} // namespace
+
+// Even threads produce, odd threads consume, so throughput and latency are
+// reported per thread count. range(0) is the buffer capacity.
+void BM_LockRingBuffer(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        g_buffer = std::make_unique<RingBuffer<Item>>(state.range(0));
+        g_latencies.assign(state.threads(), {});
+    }
+
+    bool producer = state.thread_index() % 2 == 0;
+    int64_t sampleEvery = std::max<int64_t>(1, state.max_iterations / MAX_LATENCY_SAMPLES);
+    std::vector<int64_t> latencies;
+    if (!producer) {
+        latencies.reserve(state.max_iterations / sampleEvery + 1);
+    }
+
+    int64_t remaining = state.max_iterations;
+    for (auto _ : state) {
+        if (producer) {
+            g_buffer->Push(Item{NowNs()});
+        } else {
+            Item item{};
+            // the buffer is never closed here, so this is only a guard
+            if (!g_buffer->Pop(item)) {
+                state.SkipWithError("RingBuffer closed");
+                break;
+            }
+            if (remaining % sampleEvery == 0) {
+                latencies.push_back(NowNs() - item.sendTime);
+            }
+        }
+        // publish before the end-of-loop barrier so that thread 0 can see it
+        if (--remaining == 0 && !producer) {
+            g_latencies[state.thread_index()] = std::move(latencies);
+        }
+    }
+    state.SetItemsProcessed(producer ? state.iterations() : 0);
+
+    if (state.thread_index() == 0) {
+        std::vector<int64_t> all;
+        for (auto& samples : g_latencies) {
+            all.insert(all.end(), samples.begin(), samples.end());
+        }
+        state.counters["latency_p50_ns"] = static_cast<double>(Percentile(all, 0.50));
+        state.counters["latency_p99_ns"] = static_cast<double>(Percentile(all, 0.99));
+        g_buffer.reset();
+    }
+}
+BENCHMARK(BM_LockRingBuffer)->ArgName("capacity")->Arg(64)->Arg(1024)->ThreadRange(2, 16)->UseRealTime();
\ No newline at end of file
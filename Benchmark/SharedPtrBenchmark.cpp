@@ -0,0 +1,176 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AtomicSharedPtr.h"
+#include "IntrusivePtr.h"
+#include "MemoryPool.h"
+#include "SharedPtr.h"
+
+namespace {
+
+struct Payload {
+    int value{0};
+};
+
+template <typename CountPolicy>
+struct IntrusivePayload : RefCounted<IntrusivePayload<CountPolicy>, CountPolicy> {
+    int value{0};
+};
+
+template <typename Ptr>
+struct Factory;
+
+template <typename CountPolicy>
+struct Factory<SharedPtr<Payload, CountPolicy>> {
+    static SharedPtr<Payload, CountPolicy> Make() { return MakeShared<Payload, CountPolicy>(); }
+};
+
+template <typename CountPolicy>
+struct Factory<IntrusivePtr<IntrusivePayload<CountPolicy>>> {
+    static IntrusivePtr<IntrusivePayload<CountPolicy>> Make() { return MakeIntrusive<IntrusivePayload<CountPolicy>>(); }
+};
+
+template <>
+struct Factory<std::shared_ptr<Payload>> {
+    static std::shared_ptr<Payload> Make() { return std::make_shared<Payload>(); }
+};
+
+template <typename Ptr>
+Ptr g_shared;
+
+const size_t CREATE_BATCH = 1000;
+
+// ways to create a SharedPtr<Payload>, one control block layout or allocator each
+struct NewPtr {
+    static SharedPtr<Payload> Make() { return SharedPtr<Payload>(new Payload()); }
+};
+
+struct NewPtrPoolBlock {
+    static SharedPtr<Payload> Make() { return SharedPtr<Payload>(new Payload(), DefaultDeleter(), PoolAllocator<Payload>()); }
+};
+
+struct MakeSharedPtr {
+    static SharedPtr<Payload> Make() { return MakeShared<Payload>(); }
+};
+
+struct AllocateSharedPool {
+    static SharedPtr<Payload> Make() { return AllocateShared<Payload>(PoolAllocator<Payload>()); }
+};
+
+} // namespace
+
+// Creates CREATE_BATCH pointers and drops them again, so both allocation and
+// release are measured. MakeShared needs one allocation, SharedPtr(new T) two.
+template <typename Creator>
+void BM_CreateDestroy(benchmark::State& state)
+{
+    std::vector<SharedPtr<Payload>> ptrs(CREATE_BATCH);
+    for (auto _ : state) {
+        for (auto& p : ptrs) {
+            p = Creator::Make();
+        }
+        for (auto& p : ptrs) {
+            p.Reset();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * CREATE_BATCH);
+}
+BENCHMARK_TEMPLATE(BM_CreateDestroy, NewPtr);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, NewPtrPoolBlock);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, MakeSharedPtr);
+BENCHMARK_TEMPLATE(BM_CreateDestroy, AllocateSharedPool);
+
+// One copy plus one destruction per iteration. Every thread copies its own object,
+// so this is the uncontended cost of the count update.
+template <typename Ptr>
+void BM_CopyConfined(benchmark::State& state)
+{
+    Ptr source = Factory<Ptr>::Make();
+    for (auto _ : state) {
+        Ptr copy(source);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// As above, but all threads copy the same object, so its count ping-pongs between cores.
+template <typename Ptr>
+void BM_CopyShared(benchmark::State& state)
+{
+    if (state.thread_index() == 0) {
+        g_shared<Ptr> = Factory<Ptr>::Make();
+    }
+    for (auto _ : state) {
+        Ptr copy(g_shared<Ptr>);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        g_shared<Ptr> = Ptr();
+    }
+}
+
+BENCHMARK_TEMPLATE(BM_CopyConfined, SharedPtr<Payload, AtomicCount>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_CopyConfined, SharedPtr<Payload, NonAtomicCount>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_CopyConfined, IntrusivePtr<IntrusivePayload<AtomicCount>>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_CopyConfined, IntrusivePtr<IntrusivePayload<NonAtomicCount>>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_CopyConfined, std::shared_ptr<Payload>)->ThreadRange(1, 16);
+
+// non-atomic counts must not be shared between threads
+BENCHMARK_TEMPLATE(BM_CopyShared, SharedPtr<Payload, AtomicCount>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_CopyShared, IntrusivePtr<IntrusivePayload<AtomicCount>>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_CopyShared, std::shared_ptr<Payload>)->ThreadRange(1, 16);
+
+namespace {
+
+// The same slot guarded by a mutex, as used before AtomicSharedPtr existed.
+template <typename T>
+class MutexSharedPtr {
+public:
+    SharedPtr<T> Load() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_ptr;
+    }
+    void Store(SharedPtr<T> desired)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_ptr = std::move(desired);
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    SharedPtr<T> m_ptr;
+};
+
+template <typename Slot>
+Slot g_slot;
+
+} // namespace
+
+// Readers Load the slot while thread 0 replaces it every 64 iterations.
+template <typename Slot>
+void BM_SlotLoad(benchmark::State& state)
+{
+    Slot& slot = g_slot<Slot>;
+    if (state.thread_index() == 0) {
+        slot.Store(MakeShared<Payload>());
+    }
+    int64_t i = 0;
+    for (auto _ : state) {
+        if (state.thread_index() == 0 && ++i % 64 == 0) {
+            slot.Store(MakeShared<Payload>());
+        } else {
+            benchmark::DoNotOptimize(slot.Load());
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        slot.Store(SharedPtr<Payload>());
+    }
+}
+BENCHMARK_TEMPLATE(BM_SlotLoad, AtomicSharedPtr<Payload>)->ThreadRange(1, 16);
+BENCHMARK_TEMPLATE(BM_SlotLoad, MutexSharedPtr<Payload>)->ThreadRange(1, 16);
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace {
+
+const size_t TASK_BATCH = 256;
+
+// fixed amount of CPU work per task
+uint64_t Spin(int64_t rounds)
+{
+    uint64_t x = 88172645463325252ull;
+    for (int64_t i = 0; i < rounds; ++i) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+    }
+    return x;
+}
+
+} // namespace
+
+// Cost of CommitTask plus the round trip through a worker for an empty task.
+// range(0) is the number of workers.
+void BM_ThreadPoolTaskOverhead(benchmark::State& state)
+{
+    ThreadPool pool(state.range(0));
+    std::vector<std::future<void>> results;
+    results.reserve(TASK_BATCH);
+
+    for (auto _ : state) {
+        results.push_back(pool.CommitTask([]() {}));
+        if (results.size() == TASK_BATCH) {
+            for (auto& result : results) {
+                result.wait();
+            }
+            results.clear();
+        }
+    }
+    for (auto& result : results) {
+        result.wait();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["workers"] = static_cast<double>(std::min<size_t>(state.range(0), THREADS_COUNT_MAX));
+}
+BENCHMARK(BM_ThreadPoolTaskOverhead)->ArgName("workers")->RangeMultiplier(2)->Range(1, 16)->UseRealTime();
+
+// Throughput of CPU bound tasks as workers are added.
+// range(0) is the number of workers, range(1) the rounds of work per task.
+void BM_ThreadPoolScaling(benchmark::State& state)
+{
+    ThreadPool pool(state.range(0));
+    int64_t rounds = state.range(1);
+    std::vector<std::future<uint64_t>> results;
+    results.reserve(TASK_BATCH);
+
+    for (auto _ : state) {
+        for (size_t i = 0; i < TASK_BATCH; ++i) {
+            results.push_back(pool.CommitTask(Spin, rounds));
+        }
+        for (auto& result : results) {
+            benchmark::DoNotOptimize(result.get());
+        }
+        results.clear();
+    }
+    state.SetItemsProcessed(state.iterations() * TASK_BATCH);
+    state.counters["workers"] = static_cast<double>(std::min<size_t>(state.range(0), THREADS_COUNT_MAX));
+}
+BENCHMARK(BM_ThreadPoolScaling)
+    ->ArgNames({"workers", "rounds"})
+    ->ArgsProduct({benchmark::CreateRange(1, 16, 2), {1000, 100000}})
+    ->UseRealTime();
\ No newline at end of file
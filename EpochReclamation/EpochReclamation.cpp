@@ -0,0 +1,237 @@
+#include "EpochReclamation.h"
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_set>
+
+// Per-thread state, cache line aligned so that pinning does not cause false sharing.
+struct alignas(64) EpochDomain::ThreadRecord {
+    // (epoch << 1) | 1 while pinned, 0 otherwise
+    std::atomic<uint64_t> m_state{0};
+    // owned by a live thread, or temporarily by Collect
+    std::atomic<bool> m_inUse{true};
+    ThreadRecord* m_next{nullptr};
+    size_t m_nesting{0};
+    std::vector<Retired> m_limbo;
+    // m_limbo.size() for PendingCount, only written by the owner
+    std::atomic<size_t> m_pending{0};
+};
+
+namespace {
+
+// Ids of live domains. Exiting threads check it so that they never touch the
+// records of a domain that has already been destroyed.
+std::mutex g_registryMutex;
+std::unordered_set<uint64_t> g_liveDomains;
+std::atomic<uint64_t> g_nextDomainId{1};
+
+struct ThreadCache {
+    struct Entry {
+        uint64_t domainId;
+        void* record;
+        std::atomic<bool>* inUse;
+    };
+
+    std::vector<Entry> entries;
+
+    ~ThreadCache()
+    {
+        // hand the records back, retired nodes left in them are freed by Collect or a later owner
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        for (auto& entry : entries) {
+            if (g_liveDomains.count(entry.domainId) != 0) {
+                entry.inUse->store(false, std::memory_order_release);
+            }
+        }
+    }
+};
+
+thread_local ThreadCache t_cache;
+
+} // namespace
+
+EpochDomain::EpochDomain(size_t batchSize) : m_batchSize(std::max<size_t>(1, batchSize))
+{
+    m_id = g_nextDomainId.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(g_registryMutex);
+    g_liveDomains.insert(m_id);
+}
+
+EpochDomain::~EpochDomain()
+{
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        g_liveDomains.erase(m_id);
+    }
+
+    // A reclaim callback may retire further nodes into any record, so swap each
+    // limbo out before running it and repeat until all of them stay empty. The
+    // list is reloaded on every pass, retiring can add a record for this thread.
+    bool reclaimed = true;
+    while (reclaimed) {
+        reclaimed = false;
+        for (ThreadRecord* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+            std::vector<Retired> limbo;
+            limbo.swap(record->m_limbo);
+            for (auto& retired : limbo) {
+                retired.reclaim(retired.ptr, retired.context);
+                reclaimed = true;
+            }
+        }
+    }
+
+    ThreadRecord* record = m_records.load(std::memory_order_acquire);
+    while (record != nullptr) {
+        ThreadRecord* next = record->m_next;
+        delete record;
+        record = next;
+    }
+}
+
+EpochDomain::Guard::Guard(EpochDomain& domain) : m_record(domain.GetRecord())
+{
+    if (m_record->m_nesting++ == 0) {
+        uint64_t epoch = domain.m_globalEpoch.load(std::memory_order_acquire);
+        // release so that an advancing thread that sees this pin also sees everything done under the previous one
+        m_record->m_state.store((epoch << 1) | 1, std::memory_order_release);
+        // make the pin visible before any shared node is loaded
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+}
+
+EpochDomain::Guard::~Guard()
+{
+    if (--m_record->m_nesting == 0) {
+        m_record->m_state.store(0, std::memory_order_release);
+    }
+}
+
+EpochDomain::ThreadRecord* EpochDomain::GetRecord()
+{
+    for (auto& entry : t_cache.entries) {
+        if (entry.domainId == m_id) {
+            return static_cast<ThreadRecord*>(entry.record);
+        }
+    }
+
+    // slow path, once per thread and domain: drop entries of destroyed domains first
+    {
+        std::lock_guard<std::mutex> lock(g_registryMutex);
+        auto& entries = t_cache.entries;
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [](const ThreadCache::Entry& entry) {
+                                         return g_liveDomains.count(entry.domainId) == 0;
+                                     }),
+                      entries.end());
+    }
+    ThreadRecord* record = AcquireRecord();
+    t_cache.entries.push_back({m_id, record, &record->m_inUse});
+    return record;
+}
+
+EpochDomain::ThreadRecord* EpochDomain::AcquireRecord()
+{
+    // reuse the record of an exited thread if there is one
+    for (ThreadRecord* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+        bool expected = false;
+        if (!record->m_inUse.load(std::memory_order_relaxed) &&
+            record->m_inUse.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return record;
+        }
+    }
+
+    ThreadRecord* record = new ThreadRecord();
+    ThreadRecord* head = m_records.load(std::memory_order_relaxed);
+    do {
+        record->m_next = head;
+    } while (!m_records.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+    return record;
+}
+
+void EpochDomain::RetireErased(void* ptr, void* context, void (*reclaim)(void*, void*))
+{
+    ThreadRecord* record = GetRecord();
+    // The node must already be unlinked when the epoch is read, otherwise it could be
+    // stamped with an epoch older than a Guard that can still reach it. Our own pinned
+    // epoch is not enough, the global one may have advanced once since.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint64_t epoch = m_globalEpoch.load(std::memory_order_relaxed);
+    record->m_limbo.push_back({ptr, context, reclaim, epoch});
+    record->m_pending.store(record->m_limbo.size(), std::memory_order_relaxed);
+
+    if (record->m_limbo.size() >= m_batchSize) {
+        TryAdvance();
+        Reclaim(record);
+    }
+}
+
+uint64_t EpochDomain::TryAdvance()
+{
+    uint64_t epoch = m_globalEpoch.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (ThreadRecord* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+        uint64_t state = record->m_state.load(std::memory_order_acquire);
+        if ((state & 1) != 0 && (state >> 1) != epoch) {
+            return epoch;
+        }
+    }
+
+    if (m_globalEpoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_release, std::memory_order_relaxed)) {
+        return epoch + 1;
+    }
+    return epoch;
+}
+
+void EpochDomain::Reclaim(ThreadRecord* record)
+{
+    uint64_t epoch = m_globalEpoch.load(std::memory_order_acquire);
+    auto& limbo = record->m_limbo;
+
+    // nodes are appended in epoch order, so the safe ones form a prefix
+    auto end = std::find_if(limbo.begin(), limbo.end(), [epoch](const Retired& retired) {
+        return retired.epoch + 2 > epoch;
+    });
+    if (end == limbo.begin()) {
+        return;
+    }
+
+    // move them out first, a reclaim callback may retire further nodes
+    std::vector<Retired> ripe(limbo.begin(), end);
+    limbo.erase(limbo.begin(), end);
+    for (auto& retired : ripe) {
+        retired.reclaim(retired.ptr, retired.context);
+    }
+    record->m_pending.store(limbo.size(), std::memory_order_relaxed);
+}
+
+void EpochDomain::Collect()
+{
+    TryAdvance();
+    Reclaim(GetRecord());
+
+    // nodes retired by threads that have exited since
+    for (ThreadRecord* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+        bool expected = false;
+        if (!record->m_inUse.load(std::memory_order_relaxed) &&
+            record->m_inUse.compare_exchange_strong(expected, true, std::memory_order_acquire, std::memory_order_relaxed)) {
+            Reclaim(record);
+            record->m_inUse.store(false, std::memory_order_release);
+        }
+    }
+}
+
+size_t EpochDomain::PendingCount() const
+{
+    size_t count = 0;
+    for (ThreadRecord* record = m_records.load(std::memory_order_acquire); record != nullptr; record = record->m_next) {
+        count += record->m_pending.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+EpochDomain& EpochDomain::Default()
+{
+    static EpochDomain domain;
+    return domain;
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#ifndef EPOCH_RECLAMATION_H
+#define EPOCH_RECLAMATION_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Epoch-based deferred reclamation for lock-free structures.
+//
+// A thread enters a Guard before it dereferences shared nodes. A node that has
+// been unlinked is handed to Retire instead of being freed; it is reclaimed once
+// the global epoch has advanced twice, because by then every Guard that could
+// still see the node has been left. The epoch only advances when all pinned
+// threads have observed the current one.
+//
+// Retired nodes are batched per thread and freed by the retiring thread once its
+// batch is full, or when that thread calls Collect. Only the nodes of exited
+// threads can be freed by other threads: Collect run on idle ThreadPool workers
+// via SetIdleTask frees those, but never the partial batch of a live thread.
+class EpochDomain {
+    struct ThreadRecord;
+
+public:
+    explicit EpochDomain(size_t batchSize = 64);
+    // No thread may be inside a Guard of this domain any more.
+    ~EpochDomain();
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    class Guard {
+    public:
+        explicit Guard(EpochDomain& domain);
+        ~Guard();
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+    private:
+        ThreadRecord* m_record;
+    };
+
+    // free p with delete once no Guard can reference it
+    template <typename T>
+    void Retire(T* p);
+    // return p to pool via DeleteElement, e.g. MemoryPool<T>. The pool must be
+    // thread safe if it is also used by other threads than the reclaiming one.
+    template <typename T, typename Pool>
+    void Retire(T* p, Pool& pool);
+
+    // advance the epoch if possible, then free the safe nodes retired by the
+    // calling thread and by threads that have exited. Nodes in the batch of
+    // another live thread stay until that thread retires or collects again.
+    void Collect();
+
+    // number of retired nodes that are not freed yet
+    size_t PendingCount() const;
+
+    static EpochDomain& Default();
+
+private:
+    struct Retired {
+        void* ptr;
+        void* context;
+        void (*reclaim)(void* ptr, void* context);
+        uint64_t epoch;
+    };
+
+    ThreadRecord* GetRecord();
+    ThreadRecord* AcquireRecord();
+    void RetireErased(void* ptr, void* context, void (*reclaim)(void*, void*));
+    uint64_t TryAdvance();
+    void Reclaim(ThreadRecord* record);
+
+    std::atomic<uint64_t> m_globalEpoch{0};
+    std::atomic<ThreadRecord*> m_records{nullptr};
+    size_t m_batchSize;
+    uint64_t m_id;
+};
+
+template <typename T>
+void EpochDomain::Retire(T* p)
+{
+    RetireErased(p, nullptr, [](void* ptr, void*) {
+        delete static_cast<T*>(ptr);
+    });
+}
+
+template <typename T, typename Pool>
+void EpochDomain::Retire(T* p, Pool& pool)
+{
+    RetireErased(p, &pool, [](void* ptr, void* context) {
+        static_cast<Pool*>(context)->DeleteElement(static_cast<T*>(ptr));
+    });
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "EpochReclamation.h"
+#include "MemoryPool.h"
+#include "ThreadPool.h"
+
+const unsigned NODE_ALIVE = 0x600DF00D;
+const unsigned NODE_DEAD = 0xDEADBEEF;
+
+std::atomic<int> g_liveNodes{0};
+
+struct Node {
+    int value;
+    unsigned canary{NODE_ALIVE};
+    Node* next{nullptr};
+    Node(int v) : value(v) { ++g_liveNodes; }
+    ~Node()
+    {
+        canary = NODE_DEAD;
+        --g_liveNodes;
+    }
+};
+
+// list node that retires the rest of the list when it is freed itself
+struct ChainNode : Node {
+    EpochDomain& domain;
+    ChainNode* tail;
+    ChainNode(EpochDomain& d, ChainNode* t) : Node(0), domain(d), tail(t) {}
+    ~ChainNode()
+    {
+        if (tail != nullptr) {
+            domain.Retire(tail);
+        }
+    }
+};
+
+// Treiber stack whose popped nodes are handed to the EpochDomain.
+template <typename Allocator>
+class LockFreeStack {
+public:
+    LockFreeStack(EpochDomain& domain, Allocator& allocator) : m_domain(domain), m_allocator(allocator) {}
+    ~LockFreeStack()
+    {
+        int value;
+        while (Pop(value)) {
+        }
+    }
+
+    void Push(int value)
+    {
+        Node* node = m_allocator.NewElement(value);
+        node->next = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    bool Pop(int& value)
+    {
+        EpochDomain::Guard guard(m_domain);
+        Node* head = m_head.load(std::memory_order_acquire);
+        while (head != nullptr) {
+            // reading a freed node here is exactly what the domain prevents
+            assert(head->canary == NODE_ALIVE);
+            if (m_head.compare_exchange_weak(head, head->next, std::memory_order_acquire, std::memory_order_acquire)) {
+                value = head->value;
+                m_allocator.Retire(m_domain, head);
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    EpochDomain& m_domain;
+    Allocator& m_allocator;
+    std::atomic<Node*> m_head{nullptr};
+};
+
+struct HeapNodes {
+    Node* NewElement(int value) { return new Node(value); }
+    void Retire(EpochDomain& domain, Node* node) { domain.Retire(node); }
+};
+
+struct PoolNodes {
+    MemoryPool<Node, sizeof(Node) * 256, true> pool;
+    Node* NewElement(int value) { return pool.NewElement(value); }
+    void Retire(EpochDomain& domain, Node* node) { domain.Retire(node, pool); }
+};
+
+void print_line() { std::cout << "----------------------------------------" << std::endl; }
+
+template <typename Allocator>
+void stress(const char* name)
+{
+    const int THREADS = 4;
+    const int OPERATIONS = 100000;
+
+    std::cout << "Stress test: " << THREADS << " threads push/pop with " << name << std::endl;
+    Allocator allocator;
+    {
+        EpochDomain domain(32);
+        {
+            LockFreeStack<Allocator> stack(domain, allocator);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < THREADS; ++t) {
+                threads.emplace_back([&stack, t]() {
+                    int value;
+                    for (int i = 0; i < OPERATIONS; ++i) {
+                        stack.Push(t * OPERATIONS + i);
+                        if (i % 3 != 0) {
+                            stack.Pop(value);
+                        }
+                    }
+                });
+            }
+            for (auto& t : threads) {
+                t.join();
+            }
+        }
+        std::cout << domain.PendingCount() << " nodes still pending before the domain is destroyed" << std::endl;
+    }
+    assert(g_liveNodes == 0);
+}
+
+int main()
+{
+    std::cout << "Starting EpochReclamation tests..." << std::endl;
+    print_line();
+
+    std::cout << "Test 1: Retired node survives while a Guard is held" << std::endl;
+    {
+        EpochDomain domain(1);
+        Node* node = new Node(1);
+        {
+            EpochDomain::Guard guard(domain);
+            domain.Retire(node);
+            for (int i = 0; i < 10; ++i) {
+                domain.Collect();
+            }
+            // this thread is still pinned in an older epoch, so it cannot have been freed
+            assert(g_liveNodes == 1);
+            assert(node->canary == NODE_ALIVE);
+        }
+        domain.Collect();
+        domain.Collect();
+        domain.Collect();
+        assert(g_liveNodes == 0);
+        assert(domain.PendingCount() == 0);
+    }
+    print_line();
+
+    std::cout << "Test 2: Nested guards" << std::endl;
+    {
+        EpochDomain domain(1);
+        {
+            EpochDomain::Guard outer(domain);
+            {
+                EpochDomain::Guard inner(domain);
+            }
+            domain.Retire(new Node(2));
+            for (int i = 0; i < 10; ++i) {
+                domain.Collect();
+            }
+            assert(g_liveNodes == 1);
+        }
+        for (int i = 0; i < 3; ++i) {
+            domain.Collect();
+        }
+        assert(g_liveNodes == 0);
+    }
+    print_line();
+
+    std::cout << "Test 3: Destroying the domain frees pending nodes" << std::endl;
+    {
+        EpochDomain domain(1000);
+        for (int i = 0; i < 100; ++i) {
+            domain.Retire(new Node(i));
+        }
+        assert(domain.PendingCount() == 100);
+    }
+    assert(g_liveNodes == 0);
+
+    // each node retires its successor when it is freed, also while the domain is destroyed
+    {
+        EpochDomain domain(1000);
+        ChainNode* head = nullptr;
+        for (int i = 0; i < 50; ++i) {
+            head = new ChainNode(domain, head);
+        }
+        // retired on another thread, so the destructor's thread has no record yet
+        std::thread([&domain, head]() {
+            domain.Retire(head);
+        }).join();
+    }
+    assert(g_liveNodes == 0);
+    print_line();
+
+    std::cout << "Test 4: Idle ThreadPool workers collect nodes of exited threads" << std::endl;
+    {
+        EpochDomain domain(1000);
+        std::thread([&domain]() {
+            for (int i = 0; i < 100; ++i) {
+                domain.Retire(new Node(i));
+            }
+        }).join();
+        assert(domain.PendingCount() == 100);
+
+        ThreadPool pool(2);
+        pool.SetIdleTask([&domain]() {
+            domain.Collect();
+        }, std::chrono::milliseconds(1));
+        for (int i = 0; i < 1000 && domain.PendingCount() != 0; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        pool.SetIdleTask(nullptr);
+        assert(domain.PendingCount() == 0);
+        assert(g_liveNodes == 0);
+    }
+    print_line();
+
+    stress<HeapNodes>("new/delete");
+    stress<PoolNodes>("MemoryPool");
+    print_line();
+
+    std::cout << "All tests passed!" << std::endl;
+
+    return 0;
+}
\ No newline at end of file
@@ -6,6 +6,16 @@
 #include <mutex>
 #include <utility>
 
+// 能放下count个T的最小内存块大小：块头的next指针、最坏情况的对齐填充和count个槽
+template <typename T>
+constexpr size_t MemoryPoolBlockSize(size_t count) noexcept
+{
+    size_t align = alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+    size_t size = sizeof(T) > sizeof(void*) ? sizeof(T) : sizeof(void*);
+    size_t slot = (size + align - 1) / align * align;
+    return sizeof(void*) + align - 1 + slot * count;
+}
+
 template <typename T, size_t BlockSize = 4096, bool ThreadSafe = true>
 class MemoryPool {
 public:
@@ -22,11 +32,17 @@ public:
     T* NewElement(Args &&...args);
     // 析构一个元素并释放其内存
     void DeleteElement(T* p);
+    // 从内存池中分配一个元素的内存，不构造对象
+    T* Allocate();
+    // 将一个元素的内存返还给内存池，不析构对象
+    void Deallocate(T* p);
 private:
     union Slot {
         T element;  // 占用状态，存元素
         Slot *next; // 空闲状态，存下一个slot的指针
     };
+    // AllocateBlock之后直接返回第一个槽，块太小会写出块的边界
+    static_assert(BlockSize >= MemoryPoolBlockSize<T>(1), "BlockSize is too small for one element");
 
     Slot* m_firstBlock;     // 指向第一个内存块的指针
     Slot* m_currentSlot;    // 指向当前可用内存槽的指针
@@ -36,10 +52,6 @@ private:
 
     // 分配一个新的内存块
     void AllocateBlock();
-    // 从内存池中分配一个元素的内存
-    T* Allocate();
-    // 将一个元素的内存返还给内存池
-    void Deallocate(T* p);
     // 在指定的内存位置上构造一个对象
     template <typename U, typename... Args>
     void Construct(U* p, Args &&...args);
@@ -91,8 +103,10 @@ void MemoryPool<T, BlockSize, ThreadSafe>::AllocateBlock()
 template <typename T, size_t BlockSize, bool ThreadSafe>
 inline T* MemoryPool<T, BlockSize, ThreadSafe>::Allocate()
 {
+    // 锁的作用域必须覆盖整个函数体，不能放在if constexpr的块内
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
     if constexpr (ThreadSafe) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        lock.lock();
     }
     if (m_freeSlots != nullptr) {
         T* result = reinterpret_cast<T*>(m_freeSlots);
@@ -109,8 +123,10 @@ inline T* MemoryPool<T, BlockSize, ThreadSafe>::Allocate()
 template <typename T, size_t BlockSize, bool ThreadSafe>
 inline void MemoryPool<T, BlockSize, ThreadSafe>::Deallocate(T* p)
 {
+    // 锁的作用域必须覆盖整个函数体，不能放在if constexpr的块内
+    std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
     if constexpr (ThreadSafe) {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        lock.lock();
     }
     if (p != nullptr) {
         reinterpret_cast<Slot*>(p)->next = m_freeSlots;
@@ -161,4 +177,74 @@ inline size_t MemoryPool<T, BlockSize, ThreadSafe>::Padding(char* p, size_t alig
     return mod ? align - mod : 0;
 }
 
+// 符合标准Allocator要求的适配器，单个对象的分配走对应类型的全局MemoryPool，
+// 可以传给SharedPtr等需要Allocator的组件，让控制块等小对象从内存池分配
+template <typename T, size_t BlockSize = 4096>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    template <typename U>
+    struct rebind {
+        using other = PoolAllocator<U, BlockSize>;
+    };
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, BlockSize>&) noexcept
+    {
+    }
+
+    T* allocate(size_t n);
+    void deallocate(T* p, size_t n) noexcept;
+
+    // 每个类型共享一个线程安全的内存池。rebind得到的控制块等类型的大小不由调用者决定，
+    // 所以BlockSize放不下时按sizeof(T)扩大，保证每块至少有POOL_MIN_ELEMENTS个槽
+    static auto& Pool() noexcept;
+
+private:
+    static constexpr size_t POOL_MIN_ELEMENTS = 16;
+};
+
+template <typename T, size_t BlockSize>
+auto& PoolAllocator<T, BlockSize>::Pool() noexcept
+{
+    // 在函数内计算，PoolAllocator<T>本身在T不完整时也能实例化
+    constexpr size_t minBlockSize = MemoryPoolBlockSize<T>(POOL_MIN_ELEMENTS);
+    static MemoryPool<T, (BlockSize >= minBlockSize ? BlockSize : minBlockSize), true> pool;
+    return pool;
+}
+
+template <typename T, size_t BlockSize>
+T* PoolAllocator<T, BlockSize>::allocate(size_t n)
+{
+    // 内存池只管理单个元素大小的槽，数组分配回退到operator new
+    if (n != 1) {
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    return Pool().Allocate();
+}
+
+template <typename T, size_t BlockSize>
+void PoolAllocator<T, BlockSize>::deallocate(T* p, size_t n) noexcept
+{
+    if (n != 1) {
+        ::operator delete(p);
+        return;
+    }
+    Pool().Deallocate(p);
+}
+
+template <typename T, typename U, size_t BlockSize>
+bool operator==(const PoolAllocator<T, BlockSize>&, const PoolAllocator<U, BlockSize>&) noexcept
+{
+    return true;
+}
+
+template <typename T, typename U, size_t BlockSize>
+bool operator!=(const PoolAllocator<T, BlockSize>&, const PoolAllocator<U, BlockSize>&) noexcept
+{
+    return false;
+}
+
 #endif
\ No newline at end of file
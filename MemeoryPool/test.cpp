@@ -1,81 +1,209 @@
-#include <chrono>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
+#include <new>
+#include <set>
+#include <thread>
 #include <vector>
-#include <random>
 
 #include "MemoryPool.h"
 
+void print_line() { std::cout << "----------------------------------------" << std::endl; }
+
 struct PktBuffer {
     char buf[1500];
     size_t bufLen;
 };
 
-const int TOTAL_OPERATIONS = 1000000;
-const int PRE_ALLOC_COUNT = 1000;
-
-void testWithMemoryPool()
-{
-    MemoryPool<PktBuffer, sizeof(PktBuffer) * 256, false> pool;
-    std::vector<PktBuffer*> pkts(PRE_ALLOC_COUNT);
+// 统计构造和析构次数
+struct Counted {
+    static int s_constructed;
+    static int s_destroyed;
 
-    for (int i = 0; i < PRE_ALLOC_COUNT; ++i) {
-        pkts[i] = pool.NewElement();
-    }
+    int value;
 
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(0, PRE_ALLOC_COUNT - 1);
-
-    auto start = std::chrono::high_resolution_clock::now();
+    explicit Counted(int v = 0) : value(v) { ++s_constructed; }
+    ~Counted() { ++s_destroyed; }
+};
+int Counted::s_constructed = 0;
+int Counted::s_destroyed = 0;
 
-    for (int i = 0; i < TOTAL_OPERATIONS; ++i) {
-        int idx = distrib(gen);
-        pool.DeleteElement(pkts[idx]);
-        pkts[idx] = pool.NewElement();
-    }
+struct alignas(64) CacheLine {
+    char data[64];
+};
 
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> diff = end - start;
-    std::cout << "MemoryPool took " << diff.count() << " seconds." << std::endl;
+// 大小不是指针大小的整数倍
+struct Odd {
+    char data[13];
+};
 
-    for (int i = 0; i < PRE_ALLOC_COUNT; ++i) {
-        pool.DeleteElement(pkts[i]);
-    }
+template <typename T>
+bool IsAligned(T* p)
+{
+    return reinterpret_cast<uintptr_t>(p) % alignof(T) == 0;
 }
 
-void testWithNewDelete()
+int main()
 {
-    std::vector<PktBuffer*> pkts(PRE_ALLOC_COUNT);
-
-    for (int i = 0; i < PRE_ALLOC_COUNT; ++i) {
-        pkts[i] = new PktBuffer();
+    std::cout << "Starting MemoryPool tests..." << std::endl;
+    print_line();
+
+    std::cout << "Test 1: DeleteElement frees the slot for reuse" << std::endl;
+    {
+        MemoryPool<Counted, 4096, false> pool;
+        Counted* a = pool.NewElement(1);
+        Counted* b = pool.NewElement(2);
+        assert(a != b && a->value == 1 && b->value == 2);
+        assert(Counted::s_constructed == 2);
+
+        pool.DeleteElement(a);
+        assert(Counted::s_destroyed == 1);
+        // 空闲槽后进先出
+        Counted* c = pool.NewElement(3);
+        assert(c == a && c->value == 3);
+
+        pool.DeleteElement(b);
+        pool.DeleteElement(c);
+        Counted* d = pool.NewElement(4);
+        Counted* e = pool.NewElement(5);
+        assert(d == c && e == b);
+        pool.DeleteElement(d);
+        pool.DeleteElement(e);
+        pool.DeleteElement(nullptr);
+        assert(Counted::s_constructed == 5 && Counted::s_destroyed == 5);
+
+        // 反复分配释放不会占用新的槽
+        MemoryPool<PktBuffer, sizeof(PktBuffer) * 4, false> pktPool;
+        std::vector<PktBuffer*> pkts;
+        for (int i = 0; i < 16; ++i) {
+            pkts.push_back(pktPool.NewElement());
+        }
+        std::set<PktBuffer*> slots(pkts.begin(), pkts.end());
+        assert(slots.size() == pkts.size());
+        for (int round = 0; round < 1000; ++round) {
+            size_t idx = round * 7 % pkts.size();
+            pktPool.DeleteElement(pkts[idx]);
+            pkts[idx] = pktPool.NewElement();
+            assert(slots.count(pkts[idx]) == 1);
+        }
+        for (PktBuffer* pkt : pkts) {
+            pktPool.DeleteElement(pkt);
+        }
     }
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> distrib(0, PRE_ALLOC_COUNT - 1);
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    for (int i = 0; i < TOTAL_OPERATIONS; ++i) {
-        int idx = distrib(gen);
-        delete pkts[idx];
-        pkts[idx] = new PktBuffer();
+    print_line();
+
+    std::cout << "Test 2: Slots are aligned across blocks" << std::endl;
+    {
+        MemoryPool<CacheLine, MemoryPoolBlockSize<CacheLine>(3), false> cachePool;
+        MemoryPool<Odd, MemoryPoolBlockSize<Odd>(5), false> oddPool;
+        MemoryPool<char, MemoryPoolBlockSize<char>(1), false> charPool;
+        std::set<CacheLine*> cacheSlots;
+        std::set<Odd*> oddSlots;
+        std::set<char*> charSlots;
+        for (int i = 0; i < 100; ++i) {
+            CacheLine* line = cachePool.NewElement();
+            Odd* odd = oddPool.NewElement();
+            char* ch = charPool.NewElement('a');
+            assert(IsAligned(line) && IsAligned(odd));
+            // 空闲槽里存的是next指针，槽至少按指针对齐
+            assert(reinterpret_cast<uintptr_t>(ch) % alignof(void*) == 0);
+            assert(cacheSlots.insert(line).second);
+            assert(oddSlots.insert(odd).second);
+            assert(charSlots.insert(ch).second);
+        }
+        for (CacheLine* line : cacheSlots) {
+            cachePool.DeleteElement(line);
+        }
+        for (Odd* odd : oddSlots) {
+            oddPool.DeleteElement(odd);
+        }
+        for (char* ch : charSlots) {
+            charPool.DeleteElement(ch);
+        }
     }
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> diff = end - start;
-    std::cout << "new/delete took " << diff.count() << " seconds." << std::endl;
-
-    for (int i = 0; i < PRE_ALLOC_COUNT; ++i) {
-        delete pkts[i];
+    print_line();
+
+    std::cout << "Test 3: Allocate and Deallocate do not construct" << std::endl;
+    {
+        Counted::s_constructed = 0;
+        Counted::s_destroyed = 0;
+        MemoryPool<Counted> pool;
+        Counted* raw = pool.Allocate();
+        assert(IsAligned(raw));
+        assert(Counted::s_constructed == 0);
+
+        new (raw) Counted(7);
+        raw->~Counted();
+        pool.Deallocate(raw);
+        pool.Deallocate(nullptr);
+        assert(Counted::s_constructed == 1 && Counted::s_destroyed == 1);
+
+        // Deallocate的槽同样会被NewElement复用
+        Counted* element = pool.NewElement(8);
+        assert(element == raw && element->value == 8);
+        pool.DeleteElement(element);
+        assert(Counted::s_constructed == 2 && Counted::s_destroyed == 2);
     }
-}
+    print_line();
+
+    std::cout << "Test 4: Threads share a pool" << std::endl;
+    {
+        const int THREADS = 4;
+        const int ITEMS = 10000;
+
+        MemoryPool<int> pool;
+        std::vector<long> sums(THREADS, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&pool, &sums, t]() {
+                std::vector<int*> held;
+                for (int i = 0; i < ITEMS; ++i) {
+                    held.push_back(pool.NewElement(i));
+                    if (held.size() == 8) {
+                        for (int* element : held) {
+                            sums[t] += *element;
+                            pool.DeleteElement(element);
+                        }
+                        held.clear();
+                    }
+                }
+                for (int* element : held) {
+                    sums[t] += *element;
+                    pool.DeleteElement(element);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        for (long sum : sums) {
+            assert(sum == long(ITEMS) * (ITEMS - 1) / 2);
+        }
+    }
+    print_line();
+
+    std::cout << "Test 5: PoolAllocator" << std::endl;
+    {
+        PoolAllocator<Odd> allocator;
+        Odd* a = allocator.allocate(1);
+        assert(IsAligned(a));
+        allocator.deallocate(a, 1);
+        assert(allocator.allocate(1) == a);
+        allocator.deallocate(a, 1);
+
+        // 数组不走内存池
+        Odd* array = allocator.allocate(4);
+        assert(IsAligned(array));
+        allocator.deallocate(array, 4);
+
+        PoolAllocator<CacheLine> lineAllocator;
+        PoolAllocator<CacheLine>::rebind<Odd>::other rebound(lineAllocator);
+        assert(rebound == allocator && rebound.allocate(1) == a);
+        rebound.deallocate(a, 1);
+    }
+    print_line();
+
+    std::cout << "All tests passed!" << std::endl;
 
-int main()
-{
-    std::cout << "Performing " << TOTAL_OPERATIONS << " interleaved allocations/deallocations..." << std::endl;
-    testWithMemoryPool();
-    testWithNewDelete();
     return 0;
-}
+}
\ No newline at end of file
@@ -0,0 +1,302 @@
+#include "Pipeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// batches a task moves before it hands its thread to the other tasks
+const size_t ROUNDS_PER_TASK = 64;
+// Runs in a row that found the input ring empty before a task counts as idle.
+// Once all tasks are idle they wait on their ring instead of polling it, starting
+// at 1 us and doubling with every further idle run.
+const size_t SPIN_RUNS = 64;
+const int64_t MAX_IDLE_WAIT_US = 1000;
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+struct Pipeline::Stage {
+    Handler handler;
+    size_t parallelism;
+    std::unique_ptr<RingBuffer<PktBuffer*>> input;
+    std::atomic<size_t> active{0}; // tasks that may still push to the next stage
+};
+
+struct Pipeline::Task {
+    size_t stage;
+    std::vector<PktBuffer*> input;
+    std::vector<PktBuffer*> output;  // passed packets not yet in the next ring
+    std::vector<PktBuffer*> dropped;
+    size_t idleRuns{0};              // runs in a row that found no input
+};
+
+Pipeline::Pipeline() : Pipeline(Options())
+{
+}
+
+Pipeline::Pipeline(Options options) : m_options(options)
+{
+    if (m_options.batchSize == 0 || m_options.ringCapacity == 0) {
+        throw std::invalid_argument("Pipeline batchSize and ringCapacity must not be 0");
+    }
+}
+
+Pipeline::~Pipeline()
+{
+    Stop();
+}
+
+void Pipeline::AddStage(Handler handler, size_t parallelism)
+{
+    if (!m_tasks.empty()) {
+        throw std::runtime_error("AddStage on a started Pipeline");
+    }
+    auto stage = std::make_unique<Stage>();
+    stage->handler = std::move(handler);
+    stage->parallelism = std::max<size_t>(1, parallelism);
+    m_stages.push_back(std::move(stage));
+}
+
+size_t Pipeline::StageCount() const
+{
+    return m_stages.size();
+}
+
+void Pipeline::Start()
+{
+    if (m_stages.empty()) {
+        throw std::runtime_error("Start on a Pipeline without stages");
+    }
+    if (!m_tasks.empty()) {
+        throw std::runtime_error("Pipeline started twice");
+    }
+
+    for (size_t i = 0; i < m_stages.size(); ++i) {
+        Stage& stage = *m_stages[i];
+        stage.input = std::make_unique<RingBuffer<PktBuffer*>>(m_options.ringCapacity);
+        stage.active = stage.parallelism;
+        for (size_t j = 0; j < stage.parallelism; ++j) {
+            auto task = std::make_unique<Task>();
+            task->stage = i;
+            task->input.resize(m_options.batchSize);
+            task->output.reserve(m_options.batchSize);
+            task->dropped.reserve(m_options.batchSize);
+            m_tasks.push_back(std::move(task));
+        }
+    }
+    m_runningTasks = m_tasks.size();
+    m_idleTasks = 0;
+    m_threadPool = std::make_unique<ThreadPool>(m_tasks.size());
+    m_running = true;
+    for (auto& task : m_tasks) {
+        m_threadPool->CommitTask([this, task = task.get()]() {
+            Run(task);
+        });
+    }
+}
+
+void Pipeline::Stop()
+{
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    // every stage closes the ring of the next one once all its tasks are done
+    m_stages.front()->input->Close();
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_finished.wait(lock, [this]() {
+            return m_runningTasks == 0;
+        });
+    }
+    m_threadPool.reset();
+}
+
+void Pipeline::Run(Task* task)
+{
+    Stage& stage = *m_stages[task->stage];
+    bool last = task->stage + 1 == m_stages.size();
+
+    for (size_t round = 0; round < ROUNDS_PER_TASK; ++round) {
+        if (!Forward(task)) {
+            break;
+        }
+        size_t count = 0;
+        if (task->idleRuns < SPIN_RUNS || m_idleTasks < m_tasks.size()) {
+            count = stage.input->TryPop(task->input.data(), task->input.size());
+        } else {
+            // Keeps an idle pipeline from spinning through the ThreadPool queue. A
+            // push or Close wakes the task early. While any task still has work
+            // this never happens, it might hold the thread that task has to run on.
+            size_t shift = std::min<size_t>(task->idleRuns - SPIN_RUNS, 10);
+            std::chrono::microseconds wait(std::min(MAX_IDLE_WAIT_US, int64_t(1) << shift));
+            count = stage.input->Pop(task->input.data(), task->input.size(), wait);
+        }
+        if (count == 0) {
+            // the ring is closed only after all upstream tasks are done, so nothing can follow
+            if (stage.input->Drained()) {
+                Finish(task);
+                return;
+            }
+            if (++task->idleRuns == SPIN_RUNS) {
+                ++m_idleTasks;
+            }
+            std::this_thread::yield();
+            break;
+        }
+        if (task->idleRuns >= SPIN_RUNS) {
+            --m_idleTasks;
+        }
+        task->idleRuns = 0;
+
+        for (size_t i = 0; i < count; ++i) {
+            PktBuffer* packet = task->input[i];
+            bool pass = false;
+            try {
+                pass = stage.handler(*packet);
+            } catch (...) {
+                // Nothing waits on the future of the task, an escaping exception
+                // would end it without Finish and leave Stop waiting forever.
+            }
+            if (pass) {
+                task->output.push_back(packet);
+            } else {
+                task->dropped.push_back(packet);
+            }
+        }
+        Recycle(task->dropped.data(), task->dropped.size());
+        task->dropped.clear();
+        if (last) {
+            Recycle(task->output.data(), task->output.size());
+            task->output.clear();
+        }
+    }
+    m_threadPool->CommitTask([this, task]() {
+        Run(task);
+    });
+}
+
+bool Pipeline::Forward(Task* task)
+{
+    if (task->output.empty()) {
+        return true;
+    }
+    size_t n = m_stages[task->stage + 1]->input->TryPush(task->output.data(), task->output.size());
+    task->output.erase(task->output.begin(), task->output.begin() + n);
+    return task->output.empty();
+}
+
+void Pipeline::Finish(Task* task)
+{
+    // a finished task never runs again, it must not keep the others polling
+    if (task->idleRuns < SPIN_RUNS) {
+        ++m_idleTasks;
+    }
+    size_t next = task->stage + 1;
+    if (--m_stages[task->stage]->active == 0 && next < m_stages.size()) {
+        m_stages[next]->input->Close();
+    }
+    // notify under the lock, Stop may destroy the condition variable right after waking up
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (--m_runningTasks == 0) {
+        m_finished.notify_all();
+    }
+}
+
+void Pipeline::Recycle(PktBuffer* const* packets, size_t count)
+{
+    // one ring operation per run of packets from the same Producer. The return
+    // ring holds every packet its Producer can have in flight, so this never blocks.
+    size_t begin = 0;
+    while (begin < count) {
+        RingBuffer<PktBuffer*>* home = packets[begin]->m_home;
+        size_t end = begin + 1;
+        while (end < count && packets[end]->m_home == home) {
+            ++end;
+        }
+        home->Push(packets + begin, end - begin);
+        begin = end;
+    }
+}
+
+Pipeline::Producer::Producer(Pipeline& pipeline, size_t maxInFlight)
+    : m_pipeline(pipeline), m_returns(std::max<size_t>(1, maxInFlight)), m_maxInFlight(std::max<size_t>(1, maxInFlight))
+{
+    m_batch.reserve(m_pipeline.m_options.batchSize);
+    m_reclaimed.resize(m_pipeline.m_options.batchSize);
+}
+
+Pipeline::Producer::~Producer()
+{
+    // not Flush, which throws if Stop has run in the meantime
+    SendBatch();
+    while (m_inFlight > 0) {
+        Reclaim(true);
+    }
+}
+
+PktBuffer* Pipeline::Producer::Acquire()
+{
+    if (m_inFlight == m_maxInFlight) {
+        // the packets waiting in the batch have to move for any to come back
+        Flush();
+        if (m_inFlight == m_maxInFlight) {
+            Reclaim(true);
+        }
+    }
+    PktBuffer* packet = m_pool.Allocate();
+    packet->length = 0;
+    packet->m_home = &m_returns;
+    ++m_inFlight;
+    return packet;
+}
+
+void Pipeline::Producer::Submit(PktBuffer* packet)
+{
+    packet->timestamp = NowNs();
+    m_batch.push_back(packet);
+    if (m_batch.size() == m_pipeline.m_options.batchSize) {
+        Flush();
+    }
+}
+
+void Pipeline::Producer::Flush()
+{
+    if (!m_pipeline.m_running) {
+        throw std::runtime_error("Submit on a Pipeline that is not running");
+    }
+    SendBatch();
+    Reclaim(false);
+}
+
+void Pipeline::Producer::SendBatch()
+{
+    // The first ring stays open until Stop closes it and then takes nothing more,
+    // so a Stop racing with this call cannot strand packets in the ring.
+    size_t sent = 0;
+    if (!m_batch.empty() && m_pipeline.m_running) {
+        sent = m_pipeline.m_stages.front()->input->Push(m_batch.data(), m_batch.size());
+    }
+    // never entered the pipeline, so they can be freed right away
+    for (size_t i = sent; i < m_batch.size(); ++i) {
+        m_pool.Deallocate(m_batch[i]);
+    }
+    m_inFlight -= m_batch.size() - sent;
+    m_batch.clear();
+}
+
+void Pipeline::Producer::Reclaim(bool wait)
+{
+    size_t count = wait ? m_returns.Pop(m_reclaimed.data(), m_reclaimed.size())
+                        : m_returns.TryPop(m_reclaimed.data(), m_reclaimed.size());
+    for (size_t i = 0; i < count; ++i) {
+        m_pool.Deallocate(m_reclaimed[i]);
+    }
+    m_inFlight -= count;
+}
\ No newline at end of file
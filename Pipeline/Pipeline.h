@@ -0,0 +1,134 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "LockRingBuffer.h"
+#include "MemoryPool.h"
+#include "ThreadPool.h"
+
+// Fixed size packet buffer. It belongs to the MemoryPool of the Producer that
+// acquired it and goes back to that pool after the last stage.
+struct PktBuffer {
+    static constexpr size_t CAPACITY = 2048;
+
+    size_t length;
+    int64_t timestamp; // steady clock in ns, set by Producer::Submit
+    unsigned char data[CAPACITY];
+
+private:
+    friend class Pipeline;
+    RingBuffer<PktBuffer*>* m_home; // return ring of the owning Producer
+};
+
+// Staged packet pipeline built from MemoryPool, RingBuffer and ThreadPool.
+//
+// Packets are passed as pointers through one RingBuffer per stage, batchSize at a
+// time, so a ring lock is taken once per batch rather than once per packet. Every
+// stage runs as parallelism tasks on a ThreadPool. A task never blocks: it moves a
+// bounded number of batches and then commits itself again, so a pool with fewer
+// threads than tasks (the pool is capped at the number of cores) still makes
+// progress. Idle tasks poll their ring, as packet pipelines usually do. Once every
+// task has found its ring empty for a while, they wait on it instead with a timeout
+// growing up to 1 ms, so an idle pipeline does not keep the cores busy. The first
+// packets after such a pause can therefore be delayed by up to that timeout.
+//
+// Packets leaving the last stage, or dropped by a stage, are pushed back to the
+// return ring of their Producer, which frees them on its own thread. Each pool is
+// therefore only ever touched by one thread and needs no lock.
+class Pipeline {
+public:
+    // Called for every packet that reaches the stage. Returning false or throwing
+    // drops the packet, the exception itself is discarded. A handler of a stage
+    // with parallelism > 1 is called concurrently.
+    using Handler = std::function<bool(PktBuffer&)>;
+
+    struct Options {
+        size_t batchSize = 32;      // packets moved per ring operation
+        size_t ringCapacity = 1024; // packets queued in front of each stage
+    };
+
+    class Producer;
+
+    Pipeline();
+    explicit Pipeline(Options options);
+    // Stops the pipeline. All Producers must have been destroyed.
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // Stages run in the order they are added. Must be called before Start.
+    void AddStage(Handler handler, size_t parallelism = 1);
+    size_t StageCount() const;
+
+    void Start();
+    // Closes the input and waits until every submitted packet has left the last
+    // stage. Producers have to Flush before, and must not Submit afterwards.
+    void Stop();
+
+private:
+    struct Stage;
+    struct Task;
+
+    void Run(Task* task);
+    // false if the output of the task does not fit into the next ring yet
+    bool Forward(Task* task);
+    void Finish(Task* task);
+    static void Recycle(PktBuffer* const* packets, size_t count);
+
+    Options m_options;
+    std::vector<std::unique_ptr<Stage>> m_stages;
+    std::vector<std::unique_ptr<Task>> m_tasks;
+    std::unique_ptr<ThreadPool> m_threadPool;
+    std::atomic<bool> m_running{false};
+    std::atomic<size_t> m_idleTasks{0}; // tasks that found their ring empty for a while
+    std::mutex m_mutex;
+    std::condition_variable m_finished;
+    size_t m_runningTasks{0};
+};
+
+// Feeds packets into a running Pipeline from a single thread.
+class Pipeline::Producer {
+public:
+    // At most maxInFlight packets are acquired and not yet back in the pool.
+    explicit Producer(Pipeline& pipeline, size_t maxInFlight = 4096);
+    // Flushes and waits until all packets are back in the pool. Packets still
+    // batched when the pipeline has been stopped are freed without being sent.
+    ~Producer();
+
+    Producer(const Producer&) = delete;
+    Producer& operator=(const Producer&) = delete;
+
+    // Blocks while maxInFlight packets are in flight. Every acquired packet must be submitted.
+    PktBuffer* Acquire();
+    // The packet is sent with the next full batch or on Flush.
+    void Submit(PktBuffer* packet);
+    void Flush();
+
+    size_t InFlight() const { return m_inFlight; }
+
+private:
+    // Hands the batch to the first stage without throwing. Packets a stopped
+    // pipeline does not take go straight back to the pool.
+    void SendBatch();
+    // take returned packets back into the pool, waiting for at least one if wait is set
+    void Reclaim(bool wait);
+
+    Pipeline& m_pipeline;
+    MemoryPool<PktBuffer, sizeof(PktBuffer) * 64, false> m_pool;
+    RingBuffer<PktBuffer*> m_returns;
+    std::vector<PktBuffer*> m_batch;
+    std::vector<PktBuffer*> m_reclaimed;
+    size_t m_maxInFlight;
+    size_t m_inFlight{0};
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,258 @@
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Pipeline.h"
+
+void print_line() { std::cout << "----------------------------------------" << std::endl; }
+
+// packet payload: producer id, sequence number, stages passed
+struct Header {
+    uint32_t producer;
+    uint32_t sequence;
+    uint32_t hops;
+};
+
+Header& HeaderOf(PktBuffer& packet)
+{
+    return *reinterpret_cast<Header*>(packet.data);
+}
+
+int main()
+{
+    std::cout << "Starting Pipeline tests..." << std::endl;
+    print_line();
+
+    std::cout << "Test 1: Packets pass every stage in order" << std::endl;
+    {
+        const uint32_t PACKETS = 10000;
+        const size_t STAGES = 3;
+
+        Pipeline::Options options;
+        options.batchSize = 16;
+        options.ringCapacity = 64;
+        Pipeline pipeline(options);
+        std::atomic<bool> outOfOrder{false};
+        for (size_t i = 0; i < STAGES; ++i) {
+            pipeline.AddStage([i, &outOfOrder](PktBuffer& packet) {
+                Header& header = HeaderOf(packet);
+                if (header.hops != i) {
+                    outOfOrder = true;
+                }
+                ++header.hops;
+                return true;
+            });
+        }
+        // a single task per stage keeps the packets in order
+        uint32_t expected = 0;
+        uint64_t bytes = 0;
+        pipeline.AddStage([&expected, &bytes, &outOfOrder](PktBuffer& packet) {
+            Header& header = HeaderOf(packet);
+            if (header.hops != STAGES || header.sequence != expected++) {
+                outOfOrder = true;
+            }
+            bytes += packet.length;
+            return true;
+        });
+        assert(pipeline.StageCount() == STAGES + 1);
+        pipeline.Start();
+        {
+            Pipeline::Producer producer(pipeline, 256);
+            for (uint32_t i = 0; i < PACKETS; ++i) {
+                PktBuffer* packet = producer.Acquire();
+                assert(producer.InFlight() <= 256);
+                HeaderOf(*packet) = Header{0, i, 0};
+                packet->length = sizeof(Header);
+                producer.Submit(packet);
+            }
+            producer.Flush();
+        }
+        pipeline.Stop();
+        assert(!outOfOrder);
+        assert(expected == PACKETS);
+        assert(bytes == PACKETS * sizeof(Header));
+        std::cout << "Passed " << PACKETS << " packets through " << STAGES + 1 << " stages." << std::endl;
+    }
+    print_line();
+
+    std::cout << "Test 2: Dropped packets return to their pool" << std::endl;
+    {
+        const uint32_t PACKETS = 5000;
+
+        Pipeline pipeline;
+        std::atomic<uint32_t> received{0};
+        pipeline.AddStage([](PktBuffer& packet) {
+            return HeaderOf(packet).sequence % 2 == 0;
+        });
+        pipeline.AddStage([&received](PktBuffer&) {
+            ++received;
+            return true;
+        });
+        pipeline.Start();
+        {
+            // fewer buffers than packets, so the pool only keeps working if drops are recycled
+            Pipeline::Producer producer(pipeline, 64);
+            for (uint32_t i = 0; i < PACKETS; ++i) {
+                PktBuffer* packet = producer.Acquire();
+                HeaderOf(*packet) = Header{0, i, 0};
+                producer.Submit(packet);
+            }
+            producer.Flush();
+        }
+        assert(received == PACKETS / 2);
+        pipeline.Stop();
+    }
+    print_line();
+
+    std::cout << "Test 3: Parallel stages and several producers" << std::endl;
+    {
+        const uint32_t PRODUCERS = 3;
+        const uint32_t PACKETS = 20000;
+
+        Pipeline::Options options;
+        options.batchSize = 8;
+        options.ringCapacity = 32;
+        Pipeline pipeline(options);
+        pipeline.AddStage([](PktBuffer& packet) {
+            ++HeaderOf(packet).hops;
+            return true;
+        }, 3);
+        pipeline.AddStage([](PktBuffer& packet) {
+            ++HeaderOf(packet).hops;
+            return true;
+        }, 2);
+        std::vector<std::atomic<uint64_t>> sums(PRODUCERS);
+        std::atomic<uint32_t> received{0};
+        pipeline.AddStage([&sums, &received](PktBuffer& packet) {
+            Header& header = HeaderOf(packet);
+            assert(header.hops == 2);
+            sums[header.producer] += header.sequence;
+            ++received;
+            return true;
+        }, 2);
+        pipeline.Start();
+
+        std::vector<std::thread> threads;
+        for (uint32_t p = 0; p < PRODUCERS; ++p) {
+            threads.emplace_back([&pipeline, p]() {
+                Pipeline::Producer producer(pipeline, 128);
+                for (uint32_t i = 0; i < PACKETS; ++i) {
+                    PktBuffer* packet = producer.Acquire();
+                    HeaderOf(*packet) = Header{p, i, 0};
+                    producer.Submit(packet);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        pipeline.Stop();
+        assert(received == PRODUCERS * PACKETS);
+        for (auto& sum : sums) {
+            assert(sum == uint64_t(PACKETS) * (PACKETS - 1) / 2);
+        }
+        std::cout << "Received " << received << " packets from " << PRODUCERS << " producers." << std::endl;
+    }
+    print_line();
+
+    std::cout << "Test 4: Misuse is rejected" << std::endl;
+    {
+        Pipeline pipeline;
+        bool threw = false;
+        try {
+            pipeline.Start();
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+
+        pipeline.AddStage([](PktBuffer&) {
+            return true;
+        });
+        pipeline.Start();
+        threw = false;
+        try {
+            pipeline.AddStage([](PktBuffer&) {
+                return true;
+            });
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        assert(threw);
+        pipeline.Stop();
+        // stopping again is a no-op
+        pipeline.Stop();
+    }
+    print_line();
+
+    std::cout << "Test 5: Producer outliving Stop" << std::endl;
+    {
+        std::atomic<uint32_t> received{0};
+        Pipeline pipeline;
+        pipeline.AddStage([&received](PktBuffer&) {
+            ++received;
+            return true;
+        });
+        pipeline.Start();
+        {
+            Pipeline::Producer producer(pipeline);
+            for (uint32_t i = 0; i < 40; ++i) {
+                PktBuffer* packet = producer.Acquire();
+                producer.Submit(packet);
+            }
+            // the first 32 form a full batch and are sent, the last 8 are still batched
+            pipeline.Stop();
+            bool threw = false;
+            try {
+                producer.Flush();
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            assert(threw);
+            // the destructor must not throw, it frees the 8 unsent packets
+        }
+        assert(received == 32);
+    }
+    print_line();
+
+    std::cout << "Test 6: Throwing handlers drop the packet" << std::endl;
+    {
+        const uint32_t PACKETS = 1000;
+
+        std::atomic<uint32_t> received{0};
+        Pipeline pipeline;
+        pipeline.AddStage([](PktBuffer& packet) -> bool {
+            if (HeaderOf(packet).sequence % 3 == 0) {
+                throw std::runtime_error("bad packet");
+            }
+            return true;
+        }, 2);
+        pipeline.AddStage([&received](PktBuffer&) {
+            ++received;
+            return true;
+        });
+        pipeline.Start();
+        {
+            Pipeline::Producer producer(pipeline, 64);
+            for (uint32_t i = 0; i < PACKETS; ++i) {
+                PktBuffer* packet = producer.Acquire();
+                HeaderOf(*packet) = Header{0, i, 0};
+                producer.Submit(packet);
+            }
+            producer.Flush();
+            // the destructor only returns once the dropped packets are back as well
+        }
+        pipeline.Stop();
+        assert(received == PACKETS - (PACKETS + 2) / 3);
+    }
+    print_line();
+
+    std::cout << "All tests passed!" << std::endl;
+
+    return 0;
+}
\ No newline at end of file
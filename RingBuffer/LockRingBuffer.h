@@ -1,3 +1,8 @@
+#ifndef LOCK_RING_BUFFER_H
+#define LOCK_RING_BUFFER_H
+
+#include <algorithm>
+#include <chrono>
 #include <vector>
 #include <mutex>
 #include <condition_variable>
@@ -6,14 +11,36 @@ template <typename T>
 class RingBuffer {
 public:
     explicit RingBuffer(size_t capacity);
-    void Push(const T &);
-    void Pop(T&);
+    // 返回false表示缓冲区已关闭，元素没有写入
+    bool Push(const T &);
+    // 返回false表示缓冲区已关闭且为空
+    bool Pop(T&);
+
+    // 批量版本每次调用只加一次锁
+    // 阻塞直到count个元素全部写入或缓冲区被关闭，返回写入的个数
+    size_t Push(const T* items, size_t count);
+    // 阻塞直到至少有一个元素，返回取出的个数，已关闭且为空时返回0
+    size_t Pop(T* items, size_t count);
+    // 最多等待timeout，超时或已关闭且为空时返回0
+    size_t Pop(T* items, size_t count, std::chrono::microseconds timeout);
+    // 不阻塞，返回实际写入/取出的个数
+    size_t TryPush(const T* items, size_t count);
+    size_t TryPop(T* items, size_t count);
+
+    // 关闭后唤醒所有等待的生产者和消费者，之后所有Push/TryPush都不再写入
+    void Close();
+    // 已关闭且为空，不会再取出任何元素
+    bool Drained();
 private:
+    size_t PushLocked(const T* items, size_t count);
+    size_t PopLocked(T* items, size_t count);
+
     std::vector<T> m_buffer;
     size_t m_size{0};
     size_t m_capacity;
     size_t m_head{0};
     size_t m_tail{0};
+    bool m_closed{false};
     std::mutex m_mutex;
     std::condition_variable m_notEmpty;
     std::condition_variable m_notFull;
@@ -26,27 +53,152 @@ RingBuffer<T>::RingBuffer(size_t capacity) : m_capacity(capacity)
 }
 
 template <typename T>
-void RingBuffer<T>::Push(const T &buf)
+bool RingBuffer<T>::Push(const T &buf)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
     m_notFull.wait(lock, [this](){
-        return m_size < m_capacity;
+        return m_size < m_capacity || m_closed;
     });
+    if (m_closed) {
+        return false;
+    }
     m_buffer[m_head] = buf;
     m_head = (m_head + 1) % m_capacity;
     m_size++;
     m_notEmpty.notify_one();
+    return true;
 }
 
 template <typename T>
-void RingBuffer<T>::Pop(T& buf)
+bool RingBuffer<T>::Pop(T& buf)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
     m_notEmpty.wait(lock, [this](){
-        return m_size > 0;
+        return m_size > 0 || m_closed;
     });
+    if (m_size == 0) {
+        return false;
+    }
     buf = m_buffer[m_tail];
     m_tail = (m_tail + 1) % m_capacity;
     m_size--;
     m_notFull.notify_one();
+    return true;
+}
+
+template <typename T>
+size_t RingBuffer<T>::PushLocked(const T* items, size_t count)
+{
+    // 关闭后写入的元素可能在消费者退出之后才到达，永远不会被取出
+    if (m_closed) {
+        return 0;
+    }
+    size_t n = std::min(count, m_capacity - m_size);
+    for (size_t i = 0; i < n; ++i) {
+        m_buffer[m_head] = items[i];
+        m_head = (m_head + 1) % m_capacity;
+    }
+    m_size += n;
+    return n;
+}
+
+template <typename T>
+size_t RingBuffer<T>::PopLocked(T* items, size_t count)
+{
+    size_t n = std::min(count, m_size);
+    for (size_t i = 0; i < n; ++i) {
+        items[i] = m_buffer[m_tail];
+        m_tail = (m_tail + 1) % m_capacity;
+    }
+    m_size -= n;
+    return n;
+}
+
+template <typename T>
+size_t RingBuffer<T>::Push(const T* items, size_t count)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    size_t pushed = 0;
+    while (pushed < count) {
+        m_notFull.wait(lock, [this](){
+            return m_size < m_capacity || m_closed;
+        });
+        if (m_closed) {
+            break;
+        }
+        pushed += PushLocked(items + pushed, count - pushed);
+        // 一次写入多个元素时可能有多个消费者可以继续
+        m_notEmpty.notify_all();
+    }
+    return pushed;
+}
+
+template <typename T>
+size_t RingBuffer<T>::Pop(T* items, size_t count)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait(lock, [this](){
+        return m_size > 0 || m_closed;
+    });
+    size_t n = PopLocked(items, count);
+    if (n > 0) {
+        m_notFull.notify_all();
+    }
+    return n;
 }
+
+template <typename T>
+size_t RingBuffer<T>::Pop(T* items, size_t count, std::chrono::microseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_notEmpty.wait_for(lock, timeout, [this](){
+        return m_size > 0 || m_closed;
+    });
+    size_t n = PopLocked(items, count);
+    if (n > 0) {
+        m_notFull.notify_all();
+    }
+    return n;
+}
+
+template <typename T>
+size_t RingBuffer<T>::TryPush(const T* items, size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t n = PushLocked(items, count);
+    if (n > 0) {
+        m_notEmpty.notify_all();
+    }
+    return n;
+}
+
+template <typename T>
+size_t RingBuffer<T>::TryPop(T* items, size_t count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t n = PopLocked(items, count);
+    if (n > 0) {
+        m_notFull.notify_all();
+    }
+    return n;
+}
+
+template <typename T>
+void RingBuffer<T>::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_closed = true;
+    }
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+}
+
+template <typename T>
+bool RingBuffer<T>::Drained()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_closed && m_size == 0;
+}
+
+#endif
\ No newline at end of file
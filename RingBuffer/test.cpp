@@ -1,87 +1,150 @@
-#include "SharedPtr.h"
-#include <iostream>
 #include <cassert>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
 
-struct MyObject {
-    int value;
-    MyObject(int v) : value(v) { std::cout << "MyObject(" << value << ") constructed." << std::endl; }
-    ~MyObject() { std::cout << "MyObject(" << value << ") destructed." << std::endl; }
-};
+#include "LockRingBuffer.h"
 
-void print_line() {
-    std::cout << "----------------------------------------" << std::endl;
-}
+void print_line() { std::cout << "----------------------------------------" << std::endl; }
 
-int main() {
-    std::cout << "Starting SharedPtr tests..." << std::endl;
+int main()
+{
+    std::cout << "Starting RingBuffer tests..." << std::endl;
     print_line();
 
-    // Test 1: Basic construction and destruction
-    std::cout << "Test 1: Basic construction and destruction" << std::endl;
+    std::cout << "Test 1: FIFO order and wrap-around" << std::endl;
     {
-        SharedPtr<MyObject> p1(new MyObject(10));
-        assert(p1.UseCount() == 1);
-        assert(p1.Unique());
-        assert(p1->value == 10);
-        std::cout << "p1 goes out of scope..." << std::endl;
-    } // p1 destructor should call MyObject destructor
+        RingBuffer<int> buffer(4);
+        int value = 0;
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 4; ++i) {
+                buffer.Push(round * 10 + i);
+            }
+            for (int i = 0; i < 4; ++i) {
+                buffer.Pop(value);
+                assert(value == round * 10 + i);
+            }
+        }
+    }
     print_line();
 
-    // Test 2: Copy construction
-    std::cout << "Test 2: Copy construction" << std::endl;
-    SharedPtr<MyObject> p2(new MyObject(20));
-    assert(p2.UseCount() == 1);
+    std::cout << "Test 2: Producers and consumers" << std::endl;
     {
-        SharedPtr<MyObject> p3 = p2;
-        assert(p2.UseCount() == 2);
-        assert(p3.UseCount() == 2);
-        assert(!p2.Unique());
-        assert(p3->value == 20);
-        std::cout << "p3 goes out of scope..." << std::endl;
-    } // p3 destructor runs, object should NOT be deleted
-    assert(p2.UseCount() == 1);
-    std::cout << "p2 goes out of scope..." << std::endl;
+        const int THREADS = 2;
+        const int ITEMS = 100000;
+
+        RingBuffer<int> buffer(64);
+        std::vector<long> sums(THREADS, 0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&buffer]() {
+                for (int i = 1; i <= ITEMS; ++i) {
+                    buffer.Push(i);
+                }
+            });
+            threads.emplace_back([&buffer, &sums, t]() {
+                int value = 0;
+                for (int i = 0; i < ITEMS; ++i) {
+                    buffer.Pop(value);
+                    sums[t] += value;
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        long total = 0;
+        for (long sum : sums) {
+            total += sum;
+        }
+        assert(total == THREADS * (long(ITEMS) * (ITEMS + 1) / 2));
+        std::cout << "Transferred " << THREADS * ITEMS << " items." << std::endl;
+    }
     print_line();
 
-    // Test 3: Copy assignment
-    std::cout << "Test 3: Copy assignment" << std::endl;
+    std::cout << "Test 3: Batches and Close" << std::endl;
     {
-        SharedPtr<MyObject> p4(new MyObject(30));
-        SharedPtr<MyObject> p5(new MyObject(40));
-        assert(p4.UseCount() == 1);
-        assert(p5.UseCount() == 1);
-
-        p4 = p5; // p4's object (30) should be destructed
-        assert(p4.UseCount() == 2);
-        assert(p5.UseCount() == 2);
-        assert(p4->value == 40);
-        std::cout << "p4 and p5 go out of scope..." << std::endl;
-    } // Both point to object(40), which should be destructed now
+        RingBuffer<int> buffer(4);
+        int items[6] = {1, 2, 3, 4, 5, 6};
+        assert(buffer.TryPush(items, 6) == 4);
+        assert(buffer.TryPush(items + 4, 2) == 0);
+
+        int out[8] = {};
+        assert(buffer.TryPop(out, 3) == 3);
+        assert(out[0] == 1 && out[2] == 3);
+
+        // the batch Push blocks until the consumer has made room
+        std::thread producer([&buffer, &items]() {
+            buffer.Push(items + 4, 2);
+            buffer.Push(items, 3);
+            buffer.Close();
+        });
+        long sum = 0;
+        size_t count = 0;
+        size_t n = 0;
+        while ((n = buffer.Pop(out, 2)) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+                sum += out[i];
+            }
+            count += n;
+        }
+        producer.join();
+        assert(count == 6);
+        assert(sum == 4 + 5 + 6 + 1 + 2 + 3);
+        assert(buffer.Drained());
+
+        int value = 0;
+        assert(!buffer.Pop(value));
+        assert(buffer.TryPop(out, 1) == 0);
+        // a closed buffer takes nothing any more
+        assert(buffer.Push(items, 2) == 0);
+        assert(buffer.TryPush(items, 1) == 0);
+        assert(!buffer.Push(items[0]));
+        assert(buffer.Drained());
+    }
     print_line();
 
-    // Test 4: Reset
-    std::cout << "Test 4: Reset" << std::endl;
-    SharedPtr<MyObject> p6(new MyObject(50));
-    assert(p6.UseCount() == 1);
-    p6.Reset(); // Object(50) should be destructed
-    assert(p6.UseCount() == 0);
-    assert(p6.Get() == nullptr);
-    std::cout << "p6 was reset." << std::endl;
+    std::cout << "Test 4: Close wakes a blocked producer" << std::endl;
+    {
+        RingBuffer<int> buffer(1);
+        assert(buffer.Push(1));
+        std::thread producer([&buffer]() {
+            // blocks on the full buffer until Close
+            assert(!buffer.Push(2));
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        buffer.Close();
+        producer.join();
+
+        int value = 0;
+        assert(buffer.Pop(value) && value == 1);
+        assert(buffer.Drained());
+    }
     print_line();
 
-    // Test 5: Move semantics
-    std::cout << "Test 5: Move semantics" << std::endl;
-    SharedPtr<MyObject> p7(new MyObject(60));
-    assert(p7.UseCount() == 1);
-    SharedPtr<MyObject> p8 = std::move(p7);
-    assert(p7.Get() == nullptr); // p7 should be null
-    assert(p7.UseCount() == 0);
-    assert(p8.UseCount() == 1);
-    assert(p8->value == 60);
-    std::cout << "p8 goes out of scope..." << std::endl;
+    std::cout << "Test 5: Pop with a timeout" << std::endl;
+    {
+        RingBuffer<int> buffer(4);
+        int out[4] = {};
+        auto start = std::chrono::steady_clock::now();
+        assert(buffer.Pop(out, 4, std::chrono::microseconds(2000)) == 0);
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::microseconds(2000));
+
+        std::thread producer([&buffer]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            buffer.Push(5);
+        });
+        // woken by the push long before the timeout
+        assert(buffer.Pop(out, 4, std::chrono::seconds(10)) == 1 && out[0] == 5);
+        producer.join();
+
+        buffer.Close();
+        assert(buffer.Pop(out, 4, std::chrono::seconds(10)) == 0);
+    }
     print_line();
 
     std::cout << "All tests passed!" << std::endl;
 
     return 0;
-}
+}
\ No newline at end of file
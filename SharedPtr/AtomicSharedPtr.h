@@ -0,0 +1,197 @@
+#ifndef ATOMIC_SHARED_PTR_H
+#define ATOMIC_SHARED_PTR_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+#include "SharedPtr.h"
+
+// A SharedPtr slot that can be loaded and replaced concurrently without a lock.
+//
+// The control block pointer and a 16-bit count of in-flight readers are packed
+// into one 64-bit word. A reader first bumps the reader count with fetch_add,
+// which pins the block because a writer that swaps it out adds that count to the
+// block's strong count before dropping the slot's own reference. The reader then
+// takes a real reference and gives its pin back: by decrementing the reader count
+// if the same block is still installed, or by releasing the reference the writer
+// added for it.
+// At most 65535 Load calls may be in flight at the same time.
+//
+// Platform requirement: control blocks must live below 2^48 with the upper 16
+// bits clear. This holds for x86-64 with 4-level paging and AArch64 without
+// pointer tagging. It does not hold with 5-level paging (LA57) mappings above
+// 2^47, or with heap pointers tagged through ARM TBI/MTE. Storing such a
+// pointer aborts the process in every build type, because its high bits
+// would otherwise be read as reader pins.
+template <typename T>
+class AtomicSharedPtr {
+public:
+    AtomicSharedPtr() noexcept;
+    explicit AtomicSharedPtr(SharedPtr<T> desired) noexcept;
+    ~AtomicSharedPtr();
+
+    AtomicSharedPtr(const AtomicSharedPtr&) = delete;
+    AtomicSharedPtr& operator=(const AtomicSharedPtr&) = delete;
+
+    SharedPtr<T> Load() const noexcept;
+    void Store(SharedPtr<T> desired) noexcept;
+    SharedPtr<T> Exchange(SharedPtr<T> desired) noexcept;
+    // Installs desired if the slot still holds the same object as expected.
+    // Otherwise expected is updated to the current value and false is returned.
+    bool CompareExchange(SharedPtr<T>& expected, SharedPtr<T> desired) noexcept;
+
+private:
+    using Block = ControlBlock<AtomicCount>;
+
+    static constexpr int POINTER_BITS = 48;
+    static constexpr uintptr_t POINTER_MASK = (uintptr_t(1) << POINTER_BITS) - 1;
+    static constexpr uintptr_t ONE_READER = uintptr_t(1) << POINTER_BITS;
+
+    static_assert(sizeof(uintptr_t) == 8, "AtomicSharedPtr requires 64-bit pointers");
+
+    static uintptr_t Pack(Block* block) noexcept;
+    static Block* BlockOf(uintptr_t packed) noexcept;
+    static size_t ReadersOf(uintptr_t packed) noexcept;
+
+    // take over the reference held by desired and return its packed value
+    static uintptr_t Adopt(SharedPtr<T>& desired) noexcept;
+    // convert the slot's reference on a swapped out block into a SharedPtr
+    static SharedPtr<T> Retire(uintptr_t old) noexcept;
+
+    mutable std::atomic<uintptr_t> m_packed{0};
+};
+
+template <typename T>
+AtomicSharedPtr<T>::AtomicSharedPtr() noexcept
+{
+}
+
+template <typename T>
+AtomicSharedPtr<T>::AtomicSharedPtr(SharedPtr<T> desired) noexcept : m_packed(Adopt(desired))
+{
+}
+
+template <typename T>
+AtomicSharedPtr<T>::~AtomicSharedPtr()
+{
+    Retire(m_packed.load(std::memory_order_acquire));
+}
+
+template <typename T>
+uintptr_t AtomicSharedPtr<T>::Pack(Block* block) noexcept
+{
+    uintptr_t value = reinterpret_cast<uintptr_t>(block);
+    // not an assert: in release builds the tag bits would silently become reader pins
+    if ((value & ~POINTER_MASK) != 0) {
+        std::fputs("AtomicSharedPtr: control block address does not fit in 48 bits\n", stderr);
+        std::abort();
+    }
+    return value;
+}
+
+template <typename T>
+typename AtomicSharedPtr<T>::Block* AtomicSharedPtr<T>::BlockOf(uintptr_t packed) noexcept
+{
+    return reinterpret_cast<Block*>(packed & POINTER_MASK);
+}
+
+template <typename T>
+size_t AtomicSharedPtr<T>::ReadersOf(uintptr_t packed) noexcept
+{
+    return packed >> POINTER_BITS;
+}
+
+template <typename T>
+uintptr_t AtomicSharedPtr<T>::Adopt(SharedPtr<T>& desired) noexcept
+{
+    uintptr_t packed = Pack(desired.m_block);
+    desired.m_data = nullptr;
+    desired.m_block = nullptr;
+    return packed;
+}
+
+template <typename T>
+SharedPtr<T> AtomicSharedPtr<T>::Retire(uintptr_t old) noexcept
+{
+    Block* block = BlockOf(old);
+    if (block == nullptr) {
+        return SharedPtr<T>();
+    }
+    // readers that pinned the block will each release one reference
+    block->AddRefs(ReadersOf(old));
+    return SharedPtr<T>(block, static_cast<T*>(block->GetPointer()));
+}
+
+template <typename T>
+SharedPtr<T> AtomicSharedPtr<T>::Load() const noexcept
+{
+    uintptr_t pinned = m_packed.fetch_add(ONE_READER, std::memory_order_acquire) + ONE_READER;
+    Block* block = BlockOf(pinned);
+    if (block != nullptr) {
+        block->AddRef();
+    }
+
+    // Give the pin back. Pins are interchangeable: if the count is already zero,
+    // another reader returned ours and the writer-added reference is released instead.
+    uintptr_t current = pinned;
+    while (true) {
+        if (BlockOf(current) != block || ReadersOf(current) == 0) {
+            if (block != nullptr) {
+                block->Release();
+            }
+            break;
+        }
+        if (m_packed.compare_exchange_weak(current, current - ONE_READER, std::memory_order_release, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+
+    if (block == nullptr) {
+        return SharedPtr<T>();
+    }
+    return SharedPtr<T>(block, static_cast<T*>(block->GetPointer()));
+}
+
+template <typename T>
+void AtomicSharedPtr<T>::Store(SharedPtr<T> desired) noexcept
+{
+    Exchange(std::move(desired));
+}
+
+template <typename T>
+SharedPtr<T> AtomicSharedPtr<T>::Exchange(SharedPtr<T> desired) noexcept
+{
+    uintptr_t old = m_packed.exchange(Adopt(desired), std::memory_order_acq_rel);
+    return Retire(old);
+}
+
+template <typename T>
+bool AtomicSharedPtr<T>::CompareExchange(SharedPtr<T>& expected, SharedPtr<T> desired) noexcept
+{
+    uintptr_t replacement = Pack(desired.m_block);
+    uintptr_t current = m_packed.load(std::memory_order_acquire);
+    while (true) {
+        if (BlockOf(current) != expected.m_block) {
+            SharedPtr<T> actual = Load();
+            if (actual.m_block == expected.m_block) {
+                // changed back in the meantime, try again
+                current = m_packed.load(std::memory_order_acquire);
+                continue;
+            }
+            expected = std::move(actual);
+            return false;
+        }
+        // a concurrent Load changes the reader count, in that case retry with the refreshed value
+        if (m_packed.compare_exchange_weak(current, replacement, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            Adopt(desired);
+            Retire(current);
+            return true;
+        }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,188 @@
+#ifndef INTRUSIVE_PTR_H
+#define INTRUSIVE_PTR_H
+
+#include <utility>
+
+#include "RefCount.h"
+
+// Base class that embeds the reference count in the object itself, so that
+// IntrusivePtr needs no control block. Derived is deleted when the last
+// reference is released.
+template <typename Derived, typename CountPolicy = AtomicCount>
+class RefCounted {
+public:
+    RefCounted(const RefCounted&) = delete;
+    RefCounted& operator=(const RefCounted&) = delete;
+
+    void AddRef() const noexcept;
+    void Release() const noexcept;
+    long UseCount() const noexcept;
+
+protected:
+    RefCounted() = default;
+    ~RefCounted() = default;
+
+private:
+    mutable typename CountPolicy::CountType m_refCount{0};
+};
+
+template <typename Derived, typename CountPolicy>
+void RefCounted<Derived, CountPolicy>::AddRef() const noexcept
+{
+    CountPolicy::Increment(m_refCount);
+}
+
+template <typename Derived, typename CountPolicy>
+void RefCounted<Derived, CountPolicy>::Release() const noexcept
+{
+    if (CountPolicy::Decrement(m_refCount) == 0) {
+        delete static_cast<const Derived*>(this);
+    }
+}
+
+template <typename Derived, typename CountPolicy>
+long RefCounted<Derived, CountPolicy>::UseCount() const noexcept
+{
+    return CountPolicy::Load(m_refCount);
+}
+
+// T must provide AddRef()/Release()/UseCount(), usually by deriving from RefCounted<T>.
+template <typename T>
+class IntrusivePtr {
+public:
+    IntrusivePtr();
+    // addRef=false adopts a reference that the caller already holds
+    explicit IntrusivePtr(T* p, bool addRef = true);
+    ~IntrusivePtr();
+
+    IntrusivePtr(const IntrusivePtr& other);
+    IntrusivePtr& operator=(const IntrusivePtr& other);
+
+    IntrusivePtr(IntrusivePtr&& other) noexcept;
+    IntrusivePtr& operator=(IntrusivePtr&& other) noexcept;
+
+    T* Get() const;
+    long UseCount() const;
+    explicit operator bool() const;
+
+    void Reset();
+    void Reset(T* p);
+
+    T& operator*() const;
+    T* operator->() const;
+
+private:
+    void swap(IntrusivePtr& other) noexcept;
+
+    T* m_data{nullptr};
+};
+
+template <typename T, typename... Args>
+IntrusivePtr<T> MakeIntrusive(Args&&... args)
+{
+    return IntrusivePtr<T>(new T(std::forward<Args>(args)...));
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr() : m_data(nullptr)
+{
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr(T* p, bool addRef) : m_data(p)
+{
+    if (m_data && addRef) {
+        m_data->AddRef();
+    }
+}
+
+template <typename T>
+IntrusivePtr<T>::~IntrusivePtr()
+{
+    if (m_data) {
+        m_data->Release();
+    }
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr(const IntrusivePtr& other) : m_data(other.m_data)
+{
+    if (m_data) {
+        m_data->AddRef();
+    }
+}
+
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=(const IntrusivePtr& other)
+{
+    // copy and swap
+    IntrusivePtr(other).swap(*this);
+    return *this;
+}
+
+template <typename T>
+IntrusivePtr<T>::IntrusivePtr(IntrusivePtr&& other) noexcept : m_data(other.m_data)
+{
+    other.m_data = nullptr;
+}
+
+template <typename T>
+IntrusivePtr<T>& IntrusivePtr<T>::operator=(IntrusivePtr&& other) noexcept
+{
+    // move and swap
+    IntrusivePtr(std::move(other)).swap(*this);
+    return *this;
+}
+
+template <typename T>
+void IntrusivePtr<T>::swap(IntrusivePtr& other) noexcept
+{
+    std::swap(m_data, other.m_data);
+}
+
+template <typename T>
+T* IntrusivePtr<T>::Get() const
+{
+    return m_data;
+}
+
+template <typename T>
+long IntrusivePtr<T>::UseCount() const
+{
+    if (m_data) {
+        return m_data->UseCount();
+    }
+    return 0;
+}
+
+template <typename T>
+IntrusivePtr<T>::operator bool() const
+{
+    return m_data != nullptr;
+}
+
+template <typename T>
+void IntrusivePtr<T>::Reset()
+{
+    IntrusivePtr().swap(*this);
+}
+
+template <typename T>
+void IntrusivePtr<T>::Reset(T* p)
+{
+    IntrusivePtr(p).swap(*this);
+}
+
+template <typename T>
+T& IntrusivePtr<T>::operator*() const
+{
+    return *m_data;
+}
+
+template <typename T>
+T* IntrusivePtr<T>::operator->() const
+{
+    return m_data;
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef REF_COUNT_H
+#define REF_COUNT_H
+
+#include <atomic>
+#include <cstddef>
+
+// Reference count policies shared by SharedPtr and IntrusivePtr.
+//
+// AtomicCount may be copied and released from any thread. NonAtomicCount
+// uses plain integer arithmetic and is only valid while every owner of the
+// object stays on one thread.
+struct AtomicCount {
+    using CountType = std::atomic<size_t>;
+
+    static void Increment(CountType& count) noexcept { count.fetch_add(1, std::memory_order_relaxed); }
+
+    static void Add(CountType& count, size_t n) noexcept { count.fetch_add(n, std::memory_order_relaxed); }
+
+    // returns the value after the decrement
+    static size_t Decrement(CountType& count) noexcept { return count.fetch_sub(1, std::memory_order_acq_rel) - 1; }
+
+    static bool IncrementIfNotZero(CountType& count) noexcept
+    {
+        size_t value = count.load(std::memory_order_relaxed);
+        while (value != 0) {
+            if (count.compare_exchange_weak(value, value + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static size_t Load(const CountType& count) noexcept { return count.load(std::memory_order_relaxed); }
+};
+
+struct NonAtomicCount {
+    using CountType = size_t;
+
+    static void Increment(CountType& count) noexcept { ++count; }
+
+    static void Add(CountType& count, size_t n) noexcept { count += n; }
+
+    static size_t Decrement(CountType& count) noexcept { return --count; }
+
+    static bool IncrementIfNotZero(CountType& count) noexcept
+    {
+        if (count == 0) {
+            return false;
+        }
+        ++count;
+        return true;
+    }
+
+    static size_t Load(const CountType& count) noexcept { return count; }
+};
+
+#endif
\ No newline at end of file
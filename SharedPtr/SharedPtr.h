@@ -1,20 +1,183 @@
 #ifndef SHARED_PTR_H
 #define SHARED_PTR_H
 
-#include <atomic>
 #include <cassert>
 #include <cstddef>
+#include <memory>
+#include <new>
 #include <utility>
 
-struct ControlBlock {
-    std::atomic<size_t> m_refCount{1};
+#include "RefCount.h"
+
+// Strong and weak counts shared by every SharedPtr/WeakPtr of one object.
+// All strong owners together hold a single weak reference, so the block is
+// freed only after the object is gone and the last WeakPtr is released.
+template <typename CountPolicy>
+class ControlBlock {
+public:
+    ControlBlock() = default;
+    ControlBlock(const ControlBlock&) = delete;
+    ControlBlock& operator=(const ControlBlock&) = delete;
+
+    void AddRef() noexcept;
+    void AddRefs(size_t n) noexcept;
+    bool TryAddRef() noexcept;
+    void Release() noexcept;
+    void AddWeakRef() noexcept;
+    void ReleaseWeak() noexcept;
+    long UseCount() const noexcept;
+
+    // the managed object, for owners that only keep the block pointer
+    virtual void* GetPointer() noexcept = 0;
+
+protected:
+    virtual ~ControlBlock() = default;
+
+    // destroy the managed object
+    virtual void Dispose() noexcept = 0;
+    // free the control block itself
+    virtual void Destroy() noexcept = 0;
+
+private:
+    typename CountPolicy::CountType m_refCount{1};
+    typename CountPolicy::CountType m_weakCount{1};
 };
 
+template <typename CountPolicy>
+inline void ControlBlock<CountPolicy>::AddRef() noexcept
+{
+    CountPolicy::Increment(m_refCount);
+}
+
+template <typename CountPolicy>
+inline void ControlBlock<CountPolicy>::AddRefs(size_t n) noexcept
+{
+    CountPolicy::Add(m_refCount, n);
+}
+
+template <typename CountPolicy>
+inline bool ControlBlock<CountPolicy>::TryAddRef() noexcept
+{
+    return CountPolicy::IncrementIfNotZero(m_refCount);
+}
+
+template <typename CountPolicy>
+inline void ControlBlock<CountPolicy>::Release() noexcept
+{
+    if (CountPolicy::Decrement(m_refCount) == 0) {
+        Dispose();
+        ReleaseWeak();
+    }
+}
+
+template <typename CountPolicy>
+inline void ControlBlock<CountPolicy>::AddWeakRef() noexcept
+{
+    CountPolicy::Increment(m_weakCount);
+}
+
+template <typename CountPolicy>
+inline void ControlBlock<CountPolicy>::ReleaseWeak() noexcept
+{
+    if (CountPolicy::Decrement(m_weakCount) == 0) {
+        Destroy();
+    }
+}
+
+template <typename CountPolicy>
+inline long ControlBlock<CountPolicy>::UseCount() const noexcept
+{
+    return CountPolicy::Load(m_refCount);
+}
+
+struct DefaultDeleter {
+    template <typename T>
+    void operator()(T* p) const noexcept
+    {
+        delete p;
+    }
+};
+
+// Control block for an object allocated separately, released through Deleter.
+template <typename T, typename Deleter, typename Alloc, typename CountPolicy>
+class PtrControlBlock : public ControlBlock<CountPolicy> {
+public:
+    PtrControlBlock(T* p, Deleter deleter, const Alloc& alloc) : m_ptr(p), m_deleter(std::move(deleter)), m_alloc(alloc) {}
+
+    void* GetPointer() noexcept override { return m_ptr; }
+
+private:
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<PtrControlBlock>;
+
+    void Dispose() noexcept override { m_deleter(m_ptr); }
+    void Destroy() noexcept override;
+
+    T* m_ptr;
+    Deleter m_deleter;
+    Alloc m_alloc;
+};
+
+template <typename T, typename Deleter, typename Alloc, typename CountPolicy>
+void PtrControlBlock<T, Deleter, Alloc, CountPolicy>::Destroy() noexcept
+{
+    BlockAlloc alloc(m_alloc);
+    this->~PtrControlBlock();
+    std::allocator_traits<BlockAlloc>::deallocate(alloc, this, 1);
+}
+
+// Control block with the object stored inline, used by MakeShared/AllocateShared
+// so that object and counts share one allocation.
+template <typename T, typename Alloc, typename CountPolicy>
+class InplaceControlBlock : public ControlBlock<CountPolicy> {
+public:
+    template <typename... Args>
+    explicit InplaceControlBlock(const Alloc& alloc, Args&&... args);
+
+    T* Get() noexcept { return std::launder(reinterpret_cast<T*>(m_storage)); }
+    void* GetPointer() noexcept override { return Get(); }
+
+private:
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<InplaceControlBlock>;
+
+    void Dispose() noexcept override { Get()->~T(); }
+    void Destroy() noexcept override;
+
+    Alloc m_alloc;
+    alignas(T) unsigned char m_storage[sizeof(T)];
+};
+
+template <typename T, typename Alloc, typename CountPolicy>
+template <typename... Args>
+InplaceControlBlock<T, Alloc, CountPolicy>::InplaceControlBlock(const Alloc& alloc, Args&&... args) : m_alloc(alloc)
+{
+    ::new (static_cast<void*>(m_storage)) T(std::forward<Args>(args)...);
+}
+
+template <typename T, typename Alloc, typename CountPolicy>
+void InplaceControlBlock<T, Alloc, CountPolicy>::Destroy() noexcept
+{
+    BlockAlloc alloc(m_alloc);
+    this->~InplaceControlBlock();
+    std::allocator_traits<BlockAlloc>::deallocate(alloc, this, 1);
+}
+
+template <typename T, typename CountPolicy = AtomicCount>
+class WeakPtr;
+
 template <typename T>
+class AtomicSharedPtr;
+
+// CountPolicy selects AtomicCount (default) or NonAtomicCount for objects
+// that never leave the creating thread, see RefCount.h.
+template <typename T, typename CountPolicy = AtomicCount>
 class SharedPtr {
 public:
     SharedPtr();
     explicit SharedPtr(T* p);
+    template <typename Deleter>
+    SharedPtr(T* p, Deleter deleter);
+    template <typename Deleter, typename Alloc>
+    SharedPtr(T* p, Deleter deleter, const Alloc& alloc);
     ~SharedPtr();
 
     SharedPtr(const SharedPtr& other);
@@ -30,135 +193,350 @@ public:
 
     void Reset();
     void Reset(T* p);
+    template <typename Deleter>
+    void Reset(T* p, Deleter deleter);
 
     T& operator*() const;
     T* operator->() const;
 
 private:
+    using Block = ControlBlock<CountPolicy>;
+
+    friend class WeakPtr<T, CountPolicy>;
+    friend class AtomicSharedPtr<T>;
+    template <typename U, typename Policy, typename Alloc, typename... Args>
+    friend SharedPtr<U, Policy> AllocateShared(const Alloc& alloc, Args&&... args);
+
+    // adopt a block whose strong reference has already been taken
+    SharedPtr(Block* block, T* p) noexcept;
+
     void Release();
     void swap(SharedPtr& other) noexcept;
 
     T* m_data{nullptr};
-    ControlBlock* m_block{nullptr};
+    Block* m_block{nullptr};
 };
 
-template <typename T>
-SharedPtr<T>::SharedPtr() : m_data(nullptr), m_block(nullptr)
+template <typename T, typename CountPolicy>
+class WeakPtr {
+public:
+    WeakPtr();
+    WeakPtr(const SharedPtr<T, CountPolicy>& shared);
+    ~WeakPtr();
+
+    WeakPtr(const WeakPtr& other);
+    WeakPtr& operator=(const WeakPtr& other);
+    WeakPtr& operator=(const SharedPtr<T, CountPolicy>& shared);
+
+    WeakPtr(WeakPtr&& other) noexcept;
+    WeakPtr& operator=(WeakPtr&& other) noexcept;
+
+    long UseCount() const;
+    bool Expired() const;
+    // returns an empty SharedPtr if the object is already destroyed
+    SharedPtr<T, CountPolicy> Lock() const;
+
+    void Reset();
+
+private:
+    using Block = ControlBlock<CountPolicy>;
+
+    void Release();
+    void swap(WeakPtr& other) noexcept;
+
+    T* m_data{nullptr};
+    Block* m_block{nullptr};
+};
+
+template <typename T, typename CountPolicy = AtomicCount, typename Alloc, typename... Args>
+SharedPtr<T, CountPolicy> AllocateShared(const Alloc& alloc, Args&&... args)
 {
+    using Block = InplaceControlBlock<T, Alloc, CountPolicy>;
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<Block>;
+
+    BlockAlloc blockAlloc(alloc);
+    Block* block = std::allocator_traits<BlockAlloc>::allocate(blockAlloc, 1);
+    try {
+        ::new (static_cast<void*>(block)) Block(alloc, std::forward<Args>(args)...);
+    } catch (...) {
+        std::allocator_traits<BlockAlloc>::deallocate(blockAlloc, block, 1);
+        throw;
+    }
+    return SharedPtr<T, CountPolicy>(block, block->Get());
 }
 
-template <typename T>
-SharedPtr<T>::SharedPtr(T* p) : m_data(p)
+template <typename T, typename CountPolicy = AtomicCount, typename... Args>
+SharedPtr<T, CountPolicy> MakeShared(Args&&... args)
+{
+    return AllocateShared<T, CountPolicy>(std::allocator<T>(), std::forward<Args>(args)...);
+}
+
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::SharedPtr() : m_data(nullptr), m_block(nullptr)
 {
-    if (m_data) {
-        m_block = new ControlBlock();
+}
+
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::SharedPtr(T* p) : SharedPtr(p, DefaultDeleter(), std::allocator<T>())
+{
+}
+
+template <typename T, typename CountPolicy>
+template <typename Deleter>
+SharedPtr<T, CountPolicy>::SharedPtr(T* p, Deleter deleter) : SharedPtr(p, std::move(deleter), std::allocator<T>())
+{
+}
+
+template <typename T, typename CountPolicy>
+template <typename Deleter, typename Alloc>
+SharedPtr<T, CountPolicy>::SharedPtr(T* p, Deleter deleter, const Alloc& alloc) : m_data(p)
+{
+    if (!m_data) {
+        return;
+    }
+
+    using PtrBlock = PtrControlBlock<T, Deleter, Alloc, CountPolicy>;
+    using BlockAlloc = typename std::allocator_traits<Alloc>::template rebind_alloc<PtrBlock>;
+
+    PtrBlock* block = nullptr;
+    try {
+        BlockAlloc blockAlloc(alloc);
+        block = std::allocator_traits<BlockAlloc>::allocate(blockAlloc, 1);
+        try {
+            // the deleter is copied so that it is still intact for the cleanup below
+            ::new (static_cast<void*>(block)) PtrBlock(p, deleter, alloc);
+        } catch (...) {
+            std::allocator_traits<BlockAlloc>::deallocate(blockAlloc, block, 1);
+            throw;
+        }
+    } catch (...) {
+        deleter(p);
+        throw;
     }
+    m_block = block;
 }
 
-template <typename T>
-SharedPtr<T>::~SharedPtr()
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::SharedPtr(Block* block, T* p) noexcept : m_data(p), m_block(block)
+{
+}
+
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::~SharedPtr()
 {
     Release();
 }
 
-template <typename T>
-void SharedPtr<T>::Release()
+template <typename T, typename CountPolicy>
+void SharedPtr<T, CountPolicy>::Release()
 {
-    if (m_block && m_block->m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-        delete m_data;
-        delete m_block;
+    if (m_block) {
+        m_block->Release();
     }
     m_data = nullptr;
     m_block = nullptr;
 }
 
-template <typename T>
-SharedPtr<T>::SharedPtr(const SharedPtr& other) : m_data(other.m_data), m_block(other.m_block)
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::SharedPtr(const SharedPtr& other) : m_data(other.m_data), m_block(other.m_block)
 {
     if (m_block) {
-        m_block->m_refCount.fetch_add(1, std::memory_order_relaxed);
+        m_block->AddRef();
     }
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=(const SharedPtr& other)
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>& SharedPtr<T, CountPolicy>::operator=(const SharedPtr& other)
 {
     // copy and swap
     SharedPtr(other).swap(*this);
     return *this;
 }
 
-template <typename T>
-SharedPtr<T>::SharedPtr(SharedPtr&& other) noexcept : m_data(other.m_data), m_block(other.m_block)
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::SharedPtr(SharedPtr&& other) noexcept : m_data(other.m_data), m_block(other.m_block)
 {
     other.m_data = nullptr;
     other.m_block = nullptr;
 }
 
-template <typename T>
-SharedPtr<T>& SharedPtr<T>::operator=(SharedPtr&& other) noexcept
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>& SharedPtr<T, CountPolicy>::operator=(SharedPtr&& other) noexcept
 {
     // move and swap
     SharedPtr(std::move(other)).swap(*this);
     return *this;
 }
 
-template <typename T>
-void SharedPtr<T>::swap(SharedPtr& other) noexcept
+template <typename T, typename CountPolicy>
+void SharedPtr<T, CountPolicy>::swap(SharedPtr& other) noexcept
 {
     std::swap(m_data, other.m_data);
     std::swap(m_block, other.m_block);
 }
 
-template <typename T>
-T* SharedPtr<T>::Get() const
+template <typename T, typename CountPolicy>
+T* SharedPtr<T, CountPolicy>::Get() const
 {
     return m_data;
 }
 
-template <typename T>
-long SharedPtr<T>::UseCount() const
+template <typename T, typename CountPolicy>
+long SharedPtr<T, CountPolicy>::UseCount() const
 {
     if (m_block) {
-        return m_block->m_refCount.load(std::memory_order_relaxed);
+        return m_block->UseCount();
     }
     return 0;
 }
 
-template <typename T>
-bool SharedPtr<T>::Unique() const
+template <typename T, typename CountPolicy>
+bool SharedPtr<T, CountPolicy>::Unique() const
 {
     return UseCount() == 1;
 }
 
-template <typename T>
-void SharedPtr<T>::Reset()
+template <typename T, typename CountPolicy>
+void SharedPtr<T, CountPolicy>::Reset()
 {
     Release();
 }
 
-template <typename T>
-void SharedPtr<T>::Reset(T* p)
+template <typename T, typename CountPolicy>
+void SharedPtr<T, CountPolicy>::Reset(T* p)
 {
     SharedPtr(p).swap(*this);
 }
 
-template <typename T>
-T& SharedPtr<T>::operator*() const
+template <typename T, typename CountPolicy>
+template <typename Deleter>
+void SharedPtr<T, CountPolicy>::Reset(T* p, Deleter deleter)
+{
+    SharedPtr(p, std::move(deleter)).swap(*this);
+}
+
+template <typename T, typename CountPolicy>
+T& SharedPtr<T, CountPolicy>::operator*() const
 {
     return *m_data;
 }
 
-template <typename T>
-T* SharedPtr<T>::operator->() const
+template <typename T, typename CountPolicy>
+T* SharedPtr<T, CountPolicy>::operator->() const
 {
     return m_data;
 }
 
-template <typename T>
-SharedPtr<T>::operator bool() const
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy>::operator bool() const
 {
     return m_data != nullptr;
 }
 
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>::WeakPtr() : m_data(nullptr), m_block(nullptr)
+{
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>::WeakPtr(const SharedPtr<T, CountPolicy>& shared) : m_data(shared.m_data), m_block(shared.m_block)
+{
+    if (m_block) {
+        m_block->AddWeakRef();
+    }
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>::~WeakPtr()
+{
+    Release();
+}
+
+template <typename T, typename CountPolicy>
+void WeakPtr<T, CountPolicy>::Release()
+{
+    if (m_block) {
+        m_block->ReleaseWeak();
+    }
+    m_data = nullptr;
+    m_block = nullptr;
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>::WeakPtr(const WeakPtr& other) : m_data(other.m_data), m_block(other.m_block)
+{
+    if (m_block) {
+        m_block->AddWeakRef();
+    }
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>& WeakPtr<T, CountPolicy>::operator=(const WeakPtr& other)
+{
+    WeakPtr(other).swap(*this);
+    return *this;
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>& WeakPtr<T, CountPolicy>::operator=(const SharedPtr<T, CountPolicy>& shared)
+{
+    WeakPtr(shared).swap(*this);
+    return *this;
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>::WeakPtr(WeakPtr&& other) noexcept : m_data(other.m_data), m_block(other.m_block)
+{
+    other.m_data = nullptr;
+    other.m_block = nullptr;
+}
+
+template <typename T, typename CountPolicy>
+WeakPtr<T, CountPolicy>& WeakPtr<T, CountPolicy>::operator=(WeakPtr&& other) noexcept
+{
+    WeakPtr(std::move(other)).swap(*this);
+    return *this;
+}
+
+template <typename T, typename CountPolicy>
+void WeakPtr<T, CountPolicy>::swap(WeakPtr& other) noexcept
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_block, other.m_block);
+}
+
+template <typename T, typename CountPolicy>
+long WeakPtr<T, CountPolicy>::UseCount() const
+{
+    if (m_block) {
+        return m_block->UseCount();
+    }
+    return 0;
+}
+
+template <typename T, typename CountPolicy>
+bool WeakPtr<T, CountPolicy>::Expired() const
+{
+    return UseCount() == 0;
+}
+
+template <typename T, typename CountPolicy>
+SharedPtr<T, CountPolicy> WeakPtr<T, CountPolicy>::Lock() const
+{
+    if (m_block && m_block->TryAddRef()) {
+        return SharedPtr<T, CountPolicy>(m_block, m_data);
+    }
+    return SharedPtr<T, CountPolicy>();
+}
+
+template <typename T, typename CountPolicy>
+void WeakPtr<T, CountPolicy>::Reset()
+{
+    Release();
+}
+
+// SharedPtr for objects confined to a single thread, see NonAtomicCount.
+template <typename T>
+using LocalSharedPtr = SharedPtr<T, NonAtomicCount>;
+
 #endif
\ No newline at end of file
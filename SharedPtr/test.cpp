@@ -1,6 +1,15 @@
+#include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
 
+#include "AtomicSharedPtr.h"
+#include "IntrusivePtr.h"
+#include "MemoryPool.h"
 #include "SharedPtr.h"
 
 struct MyObject {
@@ -9,6 +18,173 @@ struct MyObject {
     ~MyObject() { std::cout << "MyObject(" << value << ") destructed." << std::endl; }
 };
 
+struct Node {
+    int value;
+    WeakPtr<Node> parent;
+    SharedPtr<Node> child;
+    Node(int v) : value(v) {}
+};
+
+int g_intrusiveAlive = 0;
+
+template <typename CountPolicy>
+struct IntrusiveObject : RefCounted<IntrusiveObject<CountPolicy>, CountPolicy> {
+    int value;
+    IntrusiveObject(int v) : value(v) { ++g_intrusiveAlive; }
+    ~IntrusiveObject() { --g_intrusiveAlive; }
+};
+
+template <typename CountPolicy>
+void testIntrusive()
+{
+    {
+        IntrusivePtr<IntrusiveObject<CountPolicy>> i1 = MakeIntrusive<IntrusiveObject<CountPolicy>>(120);
+        assert(g_intrusiveAlive == 1);
+        assert(i1.UseCount() == 1);
+        {
+            IntrusivePtr<IntrusiveObject<CountPolicy>> i2 = i1;
+            assert(i1.UseCount() == 2);
+            // a raw pointer can be re-wrapped because the count lives in the object
+            IntrusivePtr<IntrusiveObject<CountPolicy>> i3(i2.Get());
+            assert(i3.UseCount() == 3);
+            assert(i3->value == 120);
+        }
+        assert(i1.UseCount() == 1);
+        IntrusivePtr<IntrusiveObject<CountPolicy>> i4 = std::move(i1);
+        assert(!i1);
+        assert(i4.UseCount() == 1);
+        i4.Reset();
+        assert(g_intrusiveAlive == 0);
+    }
+}
+
+std::atomic<int> g_configAlive{0};
+
+struct Config {
+    int version;
+    int checksum;
+    Config(int v) : version(v), checksum(-v) { ++g_configAlive; }
+    ~Config()
+    {
+        checksum = 0;
+        --g_configAlive;
+    }
+};
+
+void testAtomicSharedPtrConcurrent()
+{
+    const int READERS = 4;
+    const int VERSIONS = 20000;
+
+    AtomicSharedPtr<Config> slot(MakeShared<Config>(0));
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < READERS; ++i) {
+        readers.emplace_back([&slot, &done]() {
+            int lastVersion = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                SharedPtr<Config> config = slot.Load();
+                assert(config->checksum == -config->version);
+                assert(config->version >= lastVersion);
+                lastVersion = config->version;
+            }
+        });
+    }
+    for (int v = 1; v <= VERSIONS; ++v) {
+        if (v % 2) {
+            slot.Store(MakeShared<Config>(v));
+        } else {
+            SharedPtr<Config> expected = slot.Load();
+            bool swapped = slot.CompareExchange(expected, MakeShared<Config>(v));
+            assert(swapped);
+            (void)swapped;
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) {
+        t.join();
+    }
+    assert(slot.Load()->version == VERSIONS);
+    assert(g_configAlive == 1);
+}
+
+int g_deleterCalls = 0;
+
+struct CountingDeleter {
+    void operator()(MyObject* p) const
+    {
+        ++g_deleterCalls;
+        delete p;
+    }
+};
+
+// copying throws while g_throwOnCopy is set
+bool g_throwOnCopy = false;
+
+struct ThrowingDeleter {
+    ThrowingDeleter() = default;
+    ThrowingDeleter(ThrowingDeleter&&) = default;
+    ThrowingDeleter(const ThrowingDeleter&)
+    {
+        if (g_throwOnCopy) {
+            throw std::runtime_error("deleter copy failed");
+        }
+    }
+    void operator()(MyObject* p) const
+    {
+        ++g_deleterCalls;
+        delete p;
+    }
+};
+
+int g_liveAllocations = 0;
+
+template <typename T>
+struct CountingAllocator {
+    using value_type = T;
+
+    CountingAllocator() = default;
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>&)
+    {
+    }
+
+    T* allocate(size_t n)
+    {
+        ++g_liveAllocations;
+        return std::allocator<T>().allocate(n);
+    }
+    void deallocate(T* p, size_t n)
+    {
+        --g_liveAllocations;
+        std::allocator<T>().deallocate(p, n);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const CountingAllocator<T>&, const CountingAllocator<U>&)
+{
+    return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const CountingAllocator<T>&, const CountingAllocator<U>&)
+{
+    return false;
+}
+
+// larger than the default 4096 byte block of PoolAllocator
+struct BigObject {
+    char data[5000];
+    int value;
+    BigObject(int v) : value(v)
+    {
+        for (char& c : data) {
+            c = static_cast<char>(v);
+        }
+    }
+};
+
 void print_line() { std::cout << "----------------------------------------" << std::endl; }
 
 int main()
@@ -76,6 +252,146 @@ int main()
     std::cout << "p8 goes out of scope..." << std::endl;
     print_line();
 
+    std::cout << "Test 6: MakeShared" << std::endl;
+    {
+        SharedPtr<MyObject> p9 = MakeShared<MyObject>(70);
+        assert(p9.UseCount() == 1);
+        assert(p9->value == 70);
+        SharedPtr<MyObject> p10 = p9;
+        assert(p9.UseCount() == 2);
+        std::cout << "p9 and p10 go out of scope..." << std::endl;
+    }
+    print_line();
+
+    std::cout << "Test 7: WeakPtr" << std::endl;
+    {
+        WeakPtr<MyObject> w1;
+        assert(w1.Expired());
+        assert(!w1.Lock());
+        {
+            SharedPtr<MyObject> p11 = MakeShared<MyObject>(80);
+            w1 = p11;
+            assert(w1.UseCount() == 1);
+            assert(!w1.Expired());
+            SharedPtr<MyObject> p12 = w1.Lock();
+            assert(p12.UseCount() == 2);
+            assert(p12->value == 80);
+            std::cout << "p11 and p12 go out of scope..." << std::endl;
+        }
+        assert(w1.Expired());
+        assert(w1.UseCount() == 0);
+        assert(!w1.Lock());
+    }
+    print_line();
+
+    std::cout << "Test 8: WeakPtr breaks cycles" << std::endl;
+    {
+        WeakPtr<Node> observer;
+        {
+            SharedPtr<Node> root = MakeShared<Node>(1);
+            root->child = MakeShared<Node>(2);
+            root->child->parent = root;
+            observer = root->child;
+            assert(root.UseCount() == 1);
+            assert(root->child->parent.Lock()->value == 1);
+        }
+        assert(observer.Expired());
+    }
+    print_line();
+
+    std::cout << "Test 9: Custom deleter and allocator" << std::endl;
+    {
+        SharedPtr<MyObject> p13(new MyObject(90), CountingDeleter());
+        p13.Reset();
+        assert(g_deleterCalls == 1);
+
+        WeakPtr<MyObject> w2;
+        {
+            SharedPtr<MyObject> p14(new MyObject(100), CountingDeleter(), CountingAllocator<MyObject>());
+            SharedPtr<MyObject> p15 = AllocateShared<MyObject>(CountingAllocator<MyObject>(), 110);
+            assert(g_liveAllocations == 2);
+            w2 = p15;
+        }
+        assert(g_deleterCalls == 2);
+        // the weak reference keeps the control block of p15 alive
+        assert(g_liveAllocations == 1);
+        w2.Reset();
+        assert(g_liveAllocations == 0);
+
+        // a failing control block construction frees the block and deletes the object
+        g_throwOnCopy = true;
+        bool threw = false;
+        try {
+            SharedPtr<MyObject> failed(new MyObject(120), ThrowingDeleter(), CountingAllocator<MyObject>());
+        } catch (const std::runtime_error&) {
+            threw = true;
+        }
+        g_throwOnCopy = false;
+        assert(threw);
+        assert(g_deleterCalls == 3);
+        assert(g_liveAllocations == 0);
+    }
+    print_line();
+
+    std::cout << "Test 10: Non-atomic count policy" << std::endl;
+    {
+        LocalSharedPtr<MyObject> p16 = MakeShared<MyObject, NonAtomicCount>(130);
+        LocalSharedPtr<MyObject> p17 = p16;
+        assert(p16.UseCount() == 2);
+        WeakPtr<MyObject, NonAtomicCount> w3 = p17;
+        p16.Reset();
+        assert(w3.Lock()->value == 130);
+        p17.Reset();
+        assert(w3.Expired());
+    }
+    print_line();
+
+    std::cout << "Test 11: IntrusivePtr" << std::endl;
+    testIntrusive<AtomicCount>();
+    testIntrusive<NonAtomicCount>();
+    print_line();
+
+    std::cout << "Test 12: AtomicSharedPtr" << std::endl;
+    {
+        AtomicSharedPtr<MyObject> slot;
+        assert(!slot.Load());
+        SharedPtr<MyObject> p18 = MakeShared<MyObject>(140);
+        slot.Store(p18);
+        assert(p18.UseCount() == 2);
+        SharedPtr<MyObject> p19 = slot.Load();
+        assert(p19.Get() == p18.Get());
+        assert(p18.UseCount() == 3);
+
+        SharedPtr<MyObject> stale;
+        assert(!slot.CompareExchange(stale, MakeShared<MyObject>(150)));
+        assert(stale.Get() == p18.Get());
+        assert(slot.CompareExchange(stale, MakeShared<MyObject>(160)));
+        assert(slot.Load()->value == 160);
+
+        SharedPtr<MyObject> p20 = slot.Exchange(SharedPtr<MyObject>());
+        assert(p20->value == 160);
+        assert(p20.Unique());
+        assert(!slot.Load());
+        std::cout << "slot, p18-p20 and stale go out of scope..." << std::endl;
+    }
+    testAtomicSharedPtrConcurrent();
+    assert(g_configAlive == 0);
+    print_line();
+
+    std::cout << "Test 13: PoolAllocator with objects larger than its block" << std::endl;
+    {
+        std::vector<SharedPtr<BigObject>> objects;
+        for (int i = 0; i < 40; ++i) {
+            objects.push_back(AllocateShared<BigObject>(PoolAllocator<BigObject>(), i));
+            objects.push_back(SharedPtr<BigObject>(new BigObject(i), DefaultDeleter(), PoolAllocator<BigObject>()));
+        }
+        for (size_t i = 0; i < objects.size(); ++i) {
+            assert(objects[i]->value == static_cast<int>(i / 2));
+            assert(objects[i]->data[4999] == static_cast<char>(i / 2));
+        }
+    }
+    print_line();
+
     std::cout << "All tests passed!" << std::endl;
 
     return 0;
@@ -47,23 +47,46 @@ void ThreadPool::Resize(size_t newSize)
     m_condition.notify_all();
 }
 
+void ThreadPool::SetIdleTask(std::function<void()> idleTask, std::chrono::milliseconds interval)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_idleTask = std::move(idleTask);
+        m_idleInterval = interval;
+    }
+    // waiting workers pick up the new interval
+    m_condition.notify_all();
+}
+
 void ThreadPool::Worker(size_t index)
 {
     while (true) {
         std::function<void()> task;
         {
             std::unique_lock<std::mutex> lock(m_mutex);
-            m_condition.wait(lock, [this, index] {
+            auto ready = [this, index] {
                 return m_shutdown || (!m_taskQueue.empty() && index < m_coreThreads);
-            });
-
-            if (m_shutdown && m_taskQueue.empty()) {
-                return;
+            };
+            // the idle task may be installed while waiting, so check it on every wakeup
+            while (!ready()) {
+                if (!m_idleTask) {
+                    m_condition.wait(lock);
+                } else if (m_condition.wait_for(lock, m_idleInterval) == std::cv_status::timeout && !ready() && m_idleTask) {
+                    // timed out without work, run the idle task outside the lock
+                    task = m_idleTask;
+                    break;
+                }
             }
 
-            if (!m_taskQueue.empty()) {
-                task = std::move(m_taskQueue.front());
-                m_taskQueue.pop();
+            if (!task) {
+                if (m_shutdown && m_taskQueue.empty()) {
+                    return;
+                }
+
+                if (!m_taskQueue.empty()) {
+                    task = std::move(m_taskQueue.front());
+                    m_taskQueue.pop();
+                }
             }
         }
         if (task) {
@@ -2,6 +2,7 @@
 #define THREAD_POOL_H
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <functional>
 #include <future>
@@ -45,6 +46,11 @@ public:
 
     void Resize(size_t newSize);
 
+    // Runs idleTask on a worker whenever it has been waiting for work for interval,
+    // e.g. EpochDomain::Collect to free the nodes left behind by exited threads.
+    // An empty task disables it.
+    void SetIdleTask(std::function<void()> idleTask, std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
 private:
     void Worker(size_t index);
     std::queue<std::function<void()>> m_taskQueue;
@@ -53,6 +59,8 @@ private:
     std::condition_variable m_condition;
     bool m_shutdown;
     size_t m_coreThreads;
+    std::function<void()> m_idleTask;
+    std::chrono::milliseconds m_idleInterval{10};
 };
 
 #endif
\ No newline at end of file
@@ -1,13 +1,15 @@
 
 #include "ThreadPool.h"
 
+#include <cassert>
 #include <chrono>
 #include <iostream>
 
-void task(int value)
+int task(int value)
 {
     std::this_thread::sleep_for(std::chrono::milliseconds(100));
     std::cout << "Task executed with value: " << value << std::endl;
+    return value * 2;
 }
 
 
@@ -15,9 +17,17 @@ int main()
 {
     ThreadPool pool(4);
 
-    pool.CommitTask(task, 1);
+    std::vector<std::future<int>> results;
+    for (int i = 1; i <= 4; ++i) {
+        results.push_back(pool.CommitTask(task, i));
+    }
 
     std::cout << "Tasks committed." << std::endl;
 
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+    int sum = 0;
+    for (auto& result : results) {
+        sum += result.get();
+    }
+    assert(sum == 20);
+    std::cout << "All tasks finished." << std::endl;
 }
\ No newline at end of file